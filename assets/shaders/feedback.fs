@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+// Texture streaming feedback: which material slot covers this pixel and how
+// fine a mip its UVs need. Read back by TextureStreamer.
+in vec2 TexCoords;
+
+uniform int feedbackSlot;
+uniform float feedbackBias;     // log2 of how much smaller this target is than the screen
+
+void main()
+{
+    // Mip level in UV units (texture size 1); the CPU adds log2(size) per texture
+    vec2 dx = dFdx(TexCoords);
+    vec2 dy = dFdy(TexCoords);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-12)) - feedbackBias;
+
+    // slot in R/G, LOD in 1/8 steps offset by 16 in B, A marks a write
+    float code = clamp((lod + 16.0) * 8.0, 0.0, 255.0);
+    FragColor = vec4(float(feedbackSlot & 255), float((feedbackSlot >> 8) & 255), floor(code), 255.0) / 255.0;
+}
@@ -0,0 +1,39 @@
+#version 330 core
+#ifdef VERTEX_ANIMATION
+layout (location = 0) in int aVertex;
+#else
+layout (location = 0) in vec3 aPos;
+#endif
+layout (location = 2) in vec2 aTexCoords;
+
+#include "frame_data.glsl"
+
+// Animated models and crowds request mips for the pose shader.vs draws:
+// skinned by the bone palette, or instanced from the baked frames
+#ifdef SKINNED
+#include "skinning.glsl"
+#endif
+#ifdef VERTEX_ANIMATION
+#include "vertex_animation.glsl"
+layout (location = 3) in mat4 model;
+layout (location = 7) in vec2 instanceAnimation;
+#else
+uniform mat4 model;
+#endif
+
+out vec2 TexCoords;
+
+void main()
+{
+    TexCoords = aTexCoords;
+#ifdef VERTEX_ANIMATION
+    vec3 position;
+    vec3 normal;
+    vatSample(aVertex, int(instanceAnimation.x), time.x + instanceAnimation.y, position, normal);
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+#elif defined(SKINNED)
+    gl_Position = viewProjection * model * skinMatrix() * vec4(aPos, 1.0);
+#else
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+#endif
+}
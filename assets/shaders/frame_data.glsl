@@ -0,0 +1,8 @@
+// Per-frame state shared by every program, see FrameData in src/uniformBuffer.hpp
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 time;
+};
@@ -0,0 +1,39 @@
+// Scene lights shared by every lit variant, see LightData in src/lights.hpp.
+// Members are ordered so each vec3 shares a 16 byte slot with a scalar.
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    float cutOff;
+    vec3 direction;
+    float outerCutOff;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+};
+
+layout (std140) uniform LightData {
+    DirLight dirLight;
+    SpotLight spotLight;
+#if NR_POINT_LIGHTS > 0
+    PointLight pointLights[NR_POINT_LIGHTS];
+#endif
+};
@@ -4,14 +4,15 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 Position;
 
-uniform vec3 cameraPos;
+#include "frame_data.glsl"
+
 uniform samplerCube skybox;
 
 
 void main()
 {             
     float ratio = 1.00 / 1.52;
-    vec3 I = normalize(Position - cameraPos);
+    vec3 I = normalize(Position - cameraPos.xyz);
     vec3 R = refract(I, normalize(Normal), ratio);
     FragColor = vec4(texture(skybox, R).rgb, 1.0);
 } 
\ No newline at end of file
@@ -6,13 +6,13 @@ layout (location = 1) in vec3 aNormal;
 out vec3 Normal;
 out vec3 Position;
 
+#include "frame_data.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
     Normal = mat3(transpose(inverse(model))) * aNormal;
     Position = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * vec4(Position, 1.0);
+    gl_Position = viewProjection * vec4(Position, 1.0);
 }  
\ No newline at end of file
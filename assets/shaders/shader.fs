@@ -3,89 +3,100 @@
 #version 330 core
 out vec4 FragColor;
 
+// Variant features are injected by ShaderVariants; the defaults below keep
+// the file usable as a plain Shader with the full lighting model.
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 4
+#define HAS_DIR_LIGHT 1
+#define HAS_SPOT_LIGHT 1
+#define HAS_SPECULAR_MAP 1
+#endif
+
+// With TEXTURE_ARRAYS the samplers are shared arrays and each instance
+// picks its slices (x = diffuse, y = specular)
+#ifdef TEXTURE_ARRAYS
+struct Material {
+    sampler2DArray diffuse;
+    sampler2DArray specular;
+    float shininess;
+};
+flat in ivec2 MaterialLayers;
+#define MATERIAL_UV(layer) vec3(TexCoords, float(layer))
+#else
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
     float shininess;
-}; 
-
-struct DirLight {
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
 };
+#define MATERIAL_UV(layer) TexCoords
+#endif
 
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-};
-
-#define NR_POINT_LIGHTS 4
+#include "frame_data.glsl"
+#include "lights.glsl"
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
 uniform Material material;
 
+// Sampled once per fragment instead of once per light
+vec3 albedo;
+vec3 specularColor;
+
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcSpecular(vec3 lightDir, vec3 normal, vec3 viewDir);
 
 void main()
 {    
     // properties
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPos.xyz - FragPos);
+    albedo = texture(material.diffuse, MATERIAL_UV(MaterialLayers.x)).rgb;
+#ifdef HAS_SPECULAR_MAP
+    specularColor = texture(material.specular, MATERIAL_UV(MaterialLayers.y)).rgb;
+#else
+    specularColor = vec3(0.0);
+#endif
     
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
     // For each phase, a calculate function is defined that calculates the corresponding color
     // per lamp. In the main() function we take all the calculated colors and sum them up for
-    // this fragment's final color.
+    // this fragment's final color. Phases the scene does not use are compiled out.
     // == =====================================================
+    vec3 result = vec3(0.0);
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+#ifdef HAS_DIR_LIGHT
+    result += CalcDirLight(dirLight, norm, viewDir);
+#endif
     // phase 2: point lights
+#if NR_POINT_LIGHTS > 0
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+#endif
     // phase 3: spot light
+#ifdef HAS_SPOT_LIGHT
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
-    
-    
+#endif
 
     FragColor = vec4(result, 1.0);
 }
 
+// specular term, skipped entirely when the material has no specular map
+float CalcSpecular(vec3 lightDir, vec3 normal, vec3 viewDir)
+{
+#ifdef HAS_SPECULAR_MAP
+    vec3 reflectDir = reflect(-lightDir, normal);
+    return pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+#else
+    return 0.0;
+#endif
+}
+
 // calculates the color when using a directional light.
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 {
@@ -93,12 +104,11 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = CalcSpecular(lightDir, normal, viewDir);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     return (ambient + diffuse + specular);
 }
 
@@ -109,15 +119,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = CalcSpecular(lightDir, normal, viewDir);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -131,8 +140,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = CalcSpecular(lightDir, normal, viewDir);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -141,9 +149,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
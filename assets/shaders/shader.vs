@@ -1,12 +1,44 @@
 #version 330 core
+// Packed meshes store the normal as snorm 10:10:10:2 and UVs as half floats;
+// vertex fetch widens both, so the same inputs read either layout
+#ifdef VERTEX_ANIMATION
+layout(location = 0) in int aVertex;      // texel of this vertex in the baked frames
+#else
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
+#endif
 layout(location = 2) in vec2 aTexCoords;
 
-// Matrices
+#include "frame_data.glsl"
+
+#ifdef SKINNED
+#ifdef TEXTURE_ARRAYS
+#error "SKINNED and TEXTURE_ARRAYS share attribute locations 5 and 6"
+#endif
+#include "skinning.glsl"
+#endif
+
+// Crowds: positions and normals come from the baked frames; each instance
+// picks a clip and how far ahead of the shared clock it plays
+#ifdef VERTEX_ANIMATION
+#if defined(SKINNED) || defined(TEXTURE_ARRAYS)
+#error "VERTEX_ANIMATION replaces skinning and shares instance locations with TEXTURE_ARRAYS"
+#endif
+#include "vertex_animation.glsl"
+layout(location = 7) in vec2 instanceAnimation;   // clip, seconds of offset
+#endif
+
+// Matrices; batched and crowd draws supply the model (and material layers) per instance
+#if defined(TEXTURE_ARRAYS) || defined(VERTEX_ANIMATION)
+layout(location = 3) in mat4 instanceModel;
+#define model instanceModel
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+#ifdef TEXTURE_ARRAYS
+layout(location = 7) in ivec2 instanceLayers;
+flat out ivec2 MaterialLayers;
+#endif
 
 // Exports to FS
 out vec3 FragPos;  
@@ -16,7 +48,24 @@ out vec2 TexCoords;
 void main()
 {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+#ifdef TEXTURE_ARRAYS
+    MaterialLayers = instanceLayers;
+#endif
+#ifdef VERTEX_ANIMATION
+    vec3 baked;
+    vec3 normal;
+    vatSample(aVertex, int(instanceAnimation.x), time.x + instanceAnimation.y, baked, normal);
+    vec4 position = vec4(baked, 1.0);
+#else
+    vec4 position = vec4(aPos, 1.0);
+    vec3 normal = aNormal;
+#endif
+#ifdef SKINNED
+    mat4 skin = skinMatrix();
+    position = skin * position;
+    normal = mat3(skin) * normal;
+#endif
+    gl_Position = viewProjection * model * position;
+    FragPos = vec3(model * position);
+    Normal = mat3(transpose(inverse(model))) * normal;  
 }
\ No newline at end of file
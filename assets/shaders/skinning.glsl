@@ -0,0 +1,17 @@
+// Skinning: up to four bones per vertex out of the instance's palette, which
+// AnimationSystem binds per draw. Packed meshes store IDs as bytes and
+// weights as unorm; both arrive here widened.
+layout(location = 5) in ivec4 aBoneIDs;
+layout(location = 6) in vec4 aWeights;
+
+layout (std140) uniform BonePalette {
+    mat4 bones[MAX_BONES];
+};
+
+// Meshes of the model that no bone moves have no weights and stay put
+mat4 skinMatrix()
+{
+    if (dot(aWeights, vec4(1.0)) <= 0.0) return mat4(1.0);
+    return bones[aBoneIDs.x] * aWeights.x + bones[aBoneIDs.y] * aWeights.y +
+           bones[aBoneIDs.z] * aWeights.z + bones[aBoneIDs.w] * aWeights.w;
+}
@@ -0,0 +1,33 @@
+// Vertex animation textures, see VertexAnimationBake in src/vertexAnimation.hpp.
+// Every frame is vatRowsPerFrame rows of one texel per vertex; positions are
+// fractions of the bake's bounds, normals snorm. Read with texelFetch, so the
+// textures need no filtering and no mips.
+uniform sampler2D vatPositions;
+uniform sampler2D vatNormals;
+uniform vec3 vatBoundsMin;
+uniform vec3 vatBoundsExtent;
+uniform int vatRowsPerFrame;
+uniform vec4 vatClips[VAT_MAX_CLIPS];   // first frame, frame count, frames per second
+
+ivec2 vatTexel(int vertex, int frame, int width)
+{
+    return ivec2(vertex % width, frame * vatRowsPerFrame + vertex / width);
+}
+
+// Object-space position and normal `seconds` into `clip`, looping and
+// blended between the two nearest baked frames
+void vatSample(int vertex, int clip, float seconds, out vec3 position, out vec3 normal)
+{
+    vec4 c = vatClips[clip];
+    float frame = mod(seconds * c.z, c.y);
+    int count = int(c.y);
+    int f0 = min(int(frame), count - 1);
+    int f1 = f0 + 1 < count ? f0 + 1 : 0;
+    float t = frame - float(f0);
+
+    int width = textureSize(vatPositions, 0).x;
+    ivec2 a = vatTexel(vertex, int(c.x) + f0, width);
+    ivec2 b = vatTexel(vertex, int(c.x) + f1, width);
+    position = vatBoundsMin + mix(texelFetch(vatPositions, a, 0).xyz, texelFetch(vatPositions, b, 0).xyz, t) * vatBoundsExtent;
+    normal = normalize(mix(texelFetch(vatNormals, a, 0).xyz, texelFetch(vatNormals, b, 0).xyz, t));
+}
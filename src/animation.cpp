@@ -0,0 +1,225 @@
+#include "animation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIMATION_SSE 1
+#endif
+
+namespace {
+    // Four floats in one register, or a plain array where SSE is missing;
+    // everything below is written once against these helpers
+#ifdef ANIMATION_SSE
+    using Lane = __m128;
+    inline Lane load(const float* p) { return _mm_load_ps(p); }
+    inline void store(float* p, Lane v) { _mm_store_ps(p, v); }
+    inline Lane set(float x, float y, float z, float w) { return _mm_set_ps(w, z, y, x); }
+    inline Lane splat(float s) { return _mm_set1_ps(s); }
+    inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+    inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+    inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+    inline float dot(Lane a, Lane b) {
+        Lane m = _mm_mul_ps(a, b);
+        Lane s = _mm_add_ps(m, _mm_movehl_ps(m, m));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+#else
+    struct Lane { float v[4]; };
+    inline Lane load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    inline void store(float* p, Lane a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+    inline Lane set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+    inline Lane splat(float s) { return {{s, s, s, s}}; }
+    inline Lane add(Lane a, Lane b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+    inline Lane sub(Lane a, Lane b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+    inline Lane mul(Lane a, Lane b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+    inline float dot(Lane a, Lane b) { return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]; }
+#endif
+
+    inline Lane lerp(Lane a, Lane b, float t) { return add(a, mul(sub(b, a), splat(t))); }
+
+    // Shorter arc, renormalized; close enough to slerp at keyframe spacing
+    inline Lane nlerp(Lane a, Lane b, float t) {
+        if (dot(a, b) < 0.0f) b = sub(splat(0.0f), b);
+        Lane r = lerp(a, b, t);
+        float length2 = dot(r, r);
+        return length2 > 0.0f ? mul(r, splat(1.0f / std::sqrt(length2))) : a;
+    }
+
+    inline Lane load3(const glm::vec3& v) { return set(v.x, v.y, v.z, 0.0f); }
+    inline Lane load4(const glm::vec4& v) { return set(v.x, v.y, v.z, v.w); }
+
+    // a * b for column-major matrices: each result column mixes a's columns
+    void multiply(const JointMatrix& a, const JointMatrix& b, JointMatrix& out) {
+        Lane c0 = load(a.m), c1 = load(a.m + 4), c2 = load(a.m + 8), c3 = load(a.m + 12);
+        for (int col = 0; col < 4; col++) {
+            const float* bc = b.m + col * 4;
+            Lane r = mul(c0, splat(bc[0]));
+            r = add(r, mul(c1, splat(bc[1])));
+            r = add(r, mul(c2, splat(bc[2])));
+            r = add(r, mul(c3, splat(bc[3])));
+            store(out.m + col * 4, r);
+        }
+    }
+
+    // translate * rotate * scale
+    void compose(const JointPose& pose, JointMatrix& out) {
+        float x = pose.rotation[0], y = pose.rotation[1], z = pose.rotation[2], w = pose.rotation[3];
+        float sx = pose.scale[0], sy = pose.scale[1], sz = pose.scale[2];
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+        float* m = out.m;
+        m[0] = (1.0f - 2.0f * (yy + zz)) * sx; m[1] = 2.0f * (xy + wz) * sx;          m[2] = 2.0f * (xz - wy) * sx;          m[3] = 0.0f;
+        m[4] = 2.0f * (xy - wz) * sy;          m[5] = (1.0f - 2.0f * (xx + zz)) * sy; m[6] = 2.0f * (yz + wx) * sy;          m[7] = 0.0f;
+        m[8] = 2.0f * (xz + wy) * sz;          m[9] = 2.0f * (yz - wx) * sz;          m[10] = (1.0f - 2.0f * (xx + yy)) * sz; m[11] = 0.0f;
+        m[12] = pose.translation[0];           m[13] = pose.translation[1];           m[14] = pose.translation[2];           m[15] = 1.0f;
+    }
+
+    const uint16_t TRACK_INDEX_MASK = 0x3FFF;
+    const float SMALLEST_THREE_RANGE = 0.70710678f;     // no component but the largest exceeds 1/sqrt(2)
+
+    float wrapTime(float time, float duration) {
+        if (duration <= 0.0f) return 0.0f;
+        time = std::fmod(time, duration);
+        return time < 0.0f ? time + duration : time;
+    }
+
+    void decodeKey(const CompressedClip& clip, int channel, const PackedKey& key, float* out) {
+        if (channel == ROTATION_CHANNEL) {
+            int largest = key.track >> 14;
+            float sum = 0.0f;
+            for (int i = 0, k = 0; i < 4; i++) {
+                if (i == largest) continue;
+                out[i] = (key.value[k++] * (2.0f / 65535.0f) - 1.0f) * SMALLEST_THREE_RANGE;
+                sum += out[i] * out[i];
+            }
+            out[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+            return;
+        }
+        const TrackRange& range = clip.ranges[channel][key.track];
+        for (int i = 0; i < 3; i++) out[i] = range.min[i] + key.value[i] * (1.0f / 65535.0f) * range.extent[i];
+        out[3] = 0.0f;
+    }
+
+    // The keys around `time` and how far between them it is
+    bool findKeys(const std::vector<float>& times, float time, size_t& first, size_t& second, float& t) {
+        if (times.empty()) return false;
+        first = second = 0;
+        t = 0.0f;
+        if (times.size() == 1 || time <= times.front()) return true;
+        if (time >= times.back()) {
+            first = second = times.size() - 1;
+            return true;
+        }
+        second = (size_t)(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+        first = second - 1;
+        float span = times[second] - times[first];
+        t = span > 0.0f ? (time - times[first]) / span : 0.0f;
+        return true;
+    }
+}
+
+JointMatrix identityMatrix() {
+    JointMatrix m;
+    for (int i = 0; i < 16; i++) m.m[i] = i % 5 == 0 ? 1.0f : 0.0f;
+    return m;
+}
+
+void samplePose(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* out) {
+    for (size_t j = 0; j < skeleton.joints.size(); j++) out[j] = skeleton.joints[j].bind;
+
+    time = wrapTime(time, clip.duration);
+
+    size_t a, b;
+    float t;
+    for (auto& track : clip.tracks) {
+        JointPose& pose = out[track.joint];
+        if (findKeys(track.translationTimes, time, a, b, t)) {
+            store(pose.translation, lerp(load3(track.translations[a]), load3(track.translations[b]), t));
+        }
+        if (findKeys(track.rotationTimes, time, a, b, t)) {
+            store(pose.rotation, nlerp(load4(track.rotations[a]), load4(track.rotations[b]), t));
+        }
+        if (findKeys(track.scaleTimes, time, a, b, t)) {
+            store(pose.scale, lerp(load3(track.scales[a]), load3(track.scales[b]), t));
+        }
+    }
+}
+
+size_t CompressedClip::bytes() const {
+    size_t total = joints.size() * sizeof(uint16_t);
+    for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+        total += ranges[c].size() * sizeof(TrackRange) + keys[c].size() * sizeof(PackedKey);
+    }
+    return total;
+}
+
+void sampleClip(const Skeleton& skeleton, const CompressedClip& clip, ClipCursor& cursor, float time, JointPose* out) {
+    time = wrapTime(time, clip.duration);
+    if (cursor.clip != &clip || time < cursor.time) {
+        cursor.clip = &clip;
+        cursor.keys.assign(clip.trackCount() * ANIMATION_CHANNELS, ClipCursor::Keys());
+        for (auto& next : cursor.next) next = 0;
+    }
+    cursor.time = time;
+
+    // A key is due once its track has passed the key before it. Streams are
+    // sorted that way, so the first key not due ends the read.
+    for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+        const std::vector<PackedKey>& stream = clip.keys[c];
+        size_t& next = cursor.next[c];
+        for (; next < stream.size(); next++) {
+            const PackedKey& key = stream[next];
+            ClipCursor::Keys& k = cursor.keys[(key.track & TRACK_INDEX_MASK) * ANIMATION_CHANNELS + c];
+            if (k.toTime > time) break;
+            bool first = k.toTime < 0.0f;
+            std::memcpy(k.from, k.to, sizeof(k.from));
+            k.fromTime = k.toTime;
+            decodeKey(clip, c, key, k.to);
+            k.toTime = key.time * (clip.duration / 65535.0f);
+            if (first) {
+                std::memcpy(k.from, k.to, sizeof(k.from));
+                k.fromTime = k.toTime;
+            }
+        }
+    }
+
+    for (size_t j = 0; j < skeleton.joints.size(); j++) out[j] = skeleton.joints[j].bind;
+    for (size_t track = 0; track < clip.trackCount(); track++) {
+        JointPose& pose = out[clip.joints[track]];
+        float* targets[ANIMATION_CHANNELS] = {pose.translation, pose.rotation, pose.scale};
+        for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+            const ClipCursor::Keys& k = cursor.keys[track * ANIMATION_CHANNELS + c];
+            float span = k.toTime - k.fromTime;
+            float t = span > 0.0f ? std::min(std::max((time - k.fromTime) / span, 0.0f), 1.0f) : 1.0f;
+            Lane value = c == ROTATION_CHANNEL ? nlerp(load(k.from), load(k.to), t) : lerp(load(k.from), load(k.to), t);
+            store(targets[c], value);
+        }
+    }
+}
+
+void blendPoses(const JointPose* a, const JointPose* b, float weight, size_t count, JointPose* out) {
+    for (size_t j = 0; j < count; j++) {
+        Lane translation = lerp(load(a[j].translation), load(b[j].translation), weight);
+        Lane rotation = nlerp(load(a[j].rotation), load(b[j].rotation), weight);
+        Lane scale = lerp(load(a[j].scale), load(b[j].scale), weight);
+        store(out[j].translation, translation);
+        store(out[j].rotation, rotation);
+        store(out[j].scale, scale);
+    }
+}
+
+void buildPalette(const Skeleton& skeleton, const JointPose* pose, JointMatrix* globals, JointMatrix* palette) {
+    // Roots start from the inverse root transform, so the palette needs one product per bone
+    JointMatrix local;
+    for (size_t j = 0; j < skeleton.joints.size(); j++) {
+        const Joint& joint = skeleton.joints[j];
+        compose(pose[j], local);
+        const JointMatrix& parent = joint.parent >= 0 ? globals[joint.parent] : skeleton.globalInverse;
+        multiply(parent, local, globals[j]);
+        if (joint.bone >= 0) multiply(globals[j], skeleton.boneOffsets[joint.bone], palette[joint.bone]);
+    }
+}
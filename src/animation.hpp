@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define MAX_BONES 128               // palette entries per skinned draw; 8 KB of mat4 fits any UBO
+
+// Local transform of one joint. Kept as three 16-byte lanes so sampling and
+// blending run four floats at a time. Rotation is a unit quaternion (x, y, z, w).
+struct alignas(16) JointPose {
+    float translation[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float scale[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+};
+
+// Column-major 4x4, the same layout as glm::mat4
+struct alignas(16) JointMatrix {
+    float m[16];
+};
+
+struct Joint {
+    std::string name;
+    int parent = -1;            // always before this joint in Skeleton::joints
+    int bone = -1;              // palette slot, or -1 for joints no vertex is bound to
+    JointPose bind;             // rest pose, used where a clip has no track
+};
+
+// The node hierarchy of a model, parents first, and the inverse bind matrix
+// of every bone the meshes reference.
+struct Skeleton {
+    std::vector<Joint> joints;
+    std::vector<JointMatrix> boneOffsets;   // mesh space -> bone space, by palette slot
+    JointMatrix globalInverse;              // inverse of the root node's transform
+
+    size_t boneCount() const { return boneOffsets.size(); }
+};
+
+// Keyframes of one joint, times in seconds. A channel with a single key is constant.
+struct AnimationTrack {
+    int joint = -1;
+    std::vector<float> translationTimes;
+    std::vector<glm::vec3> translations;
+    std::vector<float> rotationTimes;
+    std::vector<glm::vec4> rotations;       // x, y, z, w
+    std::vector<float> scaleTimes;
+    std::vector<glm::vec3> scales;
+};
+
+struct AnimationClip {
+    std::string name;
+    float duration = 0.0f;                  // seconds
+    std::vector<AnimationTrack> tracks;
+};
+
+// Channels of a compressed clip, in stream order
+enum AnimationChannel { TRANSLATION_CHANNEL = 0, ROTATION_CHANNEL = 1, SCALE_CHANNEL = 2, ANIMATION_CHANNELS = 3 };
+
+// One quantized key: time as a fraction of the clip, the track it belongs
+// to and three 16-bit components. Rotations are smallest-three, the dropped
+// component's index in the top two bits of `track`; translations and scales
+// are fractions of their track's range.
+struct PackedKey {
+    uint16_t time;
+    uint16_t track;
+    uint16_t value[3];
+};
+
+struct TrackRange {
+    float min[3];
+    float extent[3];
+};
+
+// A clip after compressClip (animationCompress.hpp). Every track has at
+// least one key per channel. Each channel is one stream sorted by when its
+// keys are first needed: a key comes right after the time of the key before
+// it in the same track, so playing forward reads each stream front to back.
+struct CompressedClip {
+    std::string name;
+    float duration = 0.0f;
+    std::vector<uint16_t> joints;                   // track -> joint
+    std::vector<TrackRange> ranges[ANIMATION_CHANNELS];   // per track; unused for rotations
+    std::vector<PackedKey> keys[ANIMATION_CHANNELS];
+
+    size_t trackCount() const { return joints.size(); }
+    size_t keyCount() const { return keys[0].size() + keys[1].size() + keys[2].size(); }
+    size_t bytes() const;
+};
+
+// Where playback of one compressed clip is: how far each stream has been
+// read, and the two decoded keys around the last sampled time per track and
+// channel. Moving forward only reads keys not seen yet; going back rewinds.
+struct ClipCursor {
+    struct alignas(16) Keys {
+        float from[4];
+        float to[4];
+        float fromTime = 0.0f;
+        float toTime = -1.0f;       // no key read yet
+    };
+
+    const CompressedClip* clip = nullptr;
+    float time = 0.0f;
+    size_t next[ANIMATION_CHANNELS] = {0, 0, 0};
+    std::vector<Keys> keys;         // track * ANIMATION_CHANNELS + channel
+};
+
+JointMatrix identityMatrix();
+
+// Local pose of every joint at `time`, which wraps around the clip
+void samplePose(const Skeleton& skeleton, const AnimationClip& clip, float time, JointPose* out);
+
+// Same as samplePose for a compressed clip; `cursor` carries the stream
+// positions from one call to the next and is reset when it saw another clip
+void sampleClip(const Skeleton& skeleton, const CompressedClip& clip, ClipCursor& cursor, float time, JointPose* out);
+
+// out = a + (b - a) * weight per joint; rotations nlerp along the shorter arc.
+// `out` may alias either input.
+void blendPoses(const JointPose* a, const JointPose* b, float weight, size_t count, JointPose* out);
+
+// Walks the hierarchy and writes one skinning matrix per bone:
+// globalInverse * global(joint) * boneOffset. `globals` is scratch, one per joint.
+void buildPalette(const Skeleton& skeleton, const JointPose* pose, JointMatrix* globals, JointMatrix* palette);
@@ -0,0 +1,250 @@
+#include "animationCompress.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    const float SMALLEST_THREE_RANGE = 0.70710678f;     // see decodeKey in animation.cpp
+    const size_t MAX_TRACKS = 0x4000;                   // the top two bits of PackedKey::track are taken
+    const float REDUCTION_SHARE = 0.75f;                // of the tolerance; quantization and nlerp take the rest
+
+    // One channel of one track as floats, vec3 channels padded with w = 0
+    struct Channel {
+        std::vector<float> times;
+        std::vector<glm::vec4> values;
+    };
+
+    glm::vec4 interpolate(const glm::vec4& a, glm::vec4 b, float t, bool rotation) {
+        if (!rotation) return a + (b - a) * t;
+        if (glm::dot(a, b) < 0.0f) b = -b;
+        glm::vec4 r = a + (b - a) * t;
+        float length = glm::length(r);
+        return length > 0.0f ? r / length : a;
+    }
+
+    // Displacement the difference causes `distance` away from the joint
+    float boneSpaceError(const glm::vec4& a, const glm::vec4& b, int channel, float distance) {
+        if (channel == TRANSLATION_CHANNEL) return glm::length(glm::vec3(a) - glm::vec3(b));
+        if (channel == SCALE_CHANNEL) return glm::length(glm::vec3(a) - glm::vec3(b)) * distance;
+        float d = std::min(std::fabs(glm::dot(a, b)), 1.0f);
+        return 2.0f * std::acos(d) * distance;
+    }
+
+    // Greedy: stretch each segment from the last kept key until some key in
+    // between would drift past the tolerance, then keep the one before
+    std::vector<size_t> reduceKeys(const Channel& channel, int type, float tolerance, float distance) {
+        size_t n = channel.values.size();
+        std::vector<size_t> kept;
+        if (n == 0) return kept;
+
+        bool constant = true;
+        for (size_t i = 1; i < n && constant; i++) {
+            constant = boneSpaceError(channel.values[i], channel.values[0], type, distance) <= tolerance;
+        }
+        kept.push_back(0);
+        if (constant || n == 1) return kept;
+
+        size_t anchor = 0;
+        for (size_t end = 2; end < n; end++) {
+            float span = channel.times[end] - channel.times[anchor];
+            for (size_t i = anchor + 1; i < end; i++) {
+                float t = span > 0.0f ? (channel.times[i] - channel.times[anchor]) / span : 0.0f;
+                glm::vec4 value = interpolate(channel.values[anchor], channel.values[end], t, type == ROTATION_CHANNEL);
+                if (boneSpaceError(value, channel.values[i], type, distance) > tolerance) {
+                    anchor = end - 1;
+                    kept.push_back(anchor);
+                    break;
+                }
+            }
+        }
+        kept.push_back(n - 1);
+        return kept;
+    }
+
+    uint16_t quantize(float unit) {
+        return (uint16_t)std::lround(std::min(std::max(unit, 0.0f), 1.0f) * 65535.0f);
+    }
+
+    PackedKey packRotation(glm::vec4 q, uint16_t track) {
+        float length = glm::length(q);
+        q = length > 0.0f ? q / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        int largest = 0;
+        for (int i = 1; i < 4; i++) {
+            if (std::fabs(q[i]) > std::fabs(q[largest])) largest = i;
+        }
+        if (q[largest] < 0.0f) q = -q;      // q and -q are the same rotation; the decoder assumes positive
+
+        PackedKey key;
+        key.track = (uint16_t)(track | (largest << 14));
+        for (int i = 0, k = 0; i < 4; i++) {
+            if (i == largest) continue;
+            key.value[k++] = quantize((q[i] / SMALLEST_THREE_RANGE + 1.0f) * 0.5f);
+        }
+        return key;
+    }
+
+    // Bind-pose joint positions span the skeleton; tolerances scale with it
+    float skeletonSize(const Skeleton& skeleton) {
+        std::vector<JointPose> pose(skeleton.joints.size());
+        for (size_t j = 0; j < pose.size(); j++) pose[j] = skeleton.joints[j].bind;
+        std::vector<JointMatrix> globals(pose.size());
+        std::vector<JointMatrix> palette(std::max<size_t>(skeleton.boneCount(), 1));
+        buildPalette(skeleton, pose.data(), globals.data(), palette.data());
+
+        if (globals.empty()) return 1.0f;
+        glm::vec3 low(globals[0].m[12], globals[0].m[13], globals[0].m[14]), high = low;
+        for (auto& g : globals) {
+            glm::vec3 p(g.m[12], g.m[13], g.m[14]);
+            low = glm::min(low, p);
+            high = glm::max(high, p);
+        }
+        float size = glm::length(high - low);
+        return size > 0.0f ? size : 1.0f;
+    }
+
+    size_t rawBytes(const AnimationClip& clip) {
+        size_t total = clip.tracks.size() * sizeof(AnimationTrack);
+        for (auto& track : clip.tracks) {
+            total += track.translationTimes.size() * sizeof(float) + track.translations.size() * sizeof(glm::vec3);
+            total += track.rotationTimes.size() * sizeof(float) + track.rotations.size() * sizeof(glm::vec4);
+            total += track.scaleTimes.size() * sizeof(float) + track.scales.size() * sizeof(glm::vec3);
+        }
+        return total;
+    }
+}
+
+CompressedClip compressClip(const Skeleton& skeleton, const AnimationClip& clip) {
+    CompressedClip out;
+    out.name = clip.name;
+    out.duration = clip.duration;
+
+    float size = skeletonSize(skeleton);
+    float tolerance = ANIMATION_TOLERANCE * size;
+    float distance = ANIMATION_ERROR_DISTANCE * size;
+    auto quantizeTime = [&](float time) { return clip.duration > 0.0f ? quantize(time / clip.duration) : (uint16_t)0; };
+
+    // Each key is sorted by when it is first needed: the time of the key
+    // before it in its track, or before everything for a track's first key
+    struct StreamKey {
+        int32_t due;
+        PackedKey key;
+    };
+    std::vector<StreamKey> streams[ANIMATION_CHANNELS];
+
+    for (auto& source : clip.tracks) {
+        if (source.joint < 0 || out.joints.size() >= MAX_TRACKS) continue;
+        uint16_t track = (uint16_t)out.joints.size();
+        out.joints.push_back((uint16_t)source.joint);
+        const JointPose& bind = skeleton.joints[source.joint].bind;
+
+        Channel channels[ANIMATION_CHANNELS];
+        channels[TRANSLATION_CHANNEL].times = source.translationTimes;
+        for (auto& v : source.translations) channels[TRANSLATION_CHANNEL].values.push_back(glm::vec4(v, 0.0f));
+        channels[ROTATION_CHANNEL].times = source.rotationTimes;
+        channels[ROTATION_CHANNEL].values = source.rotations;
+        channels[SCALE_CHANNEL].times = source.scaleTimes;
+        for (auto& v : source.scales) channels[SCALE_CHANNEL].values.push_back(glm::vec4(v, 0.0f));
+        const float* bindValues[ANIMATION_CHANNELS] = {bind.translation, bind.rotation, bind.scale};
+
+        for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+            Channel& channel = channels[c];
+            if (channel.values.empty()) {
+                const float* v = bindValues[c];
+                channel.times.assign(1, 0.0f);
+                channel.values.assign(1, glm::vec4(v[0], v[1], v[2], c == ROTATION_CHANNEL ? v[3] : 0.0f));
+            }
+            std::vector<size_t> kept = reduceKeys(channel, c, tolerance * REDUCTION_SHARE, distance);
+
+            TrackRange range = {};
+            if (c != ROTATION_CHANNEL) {
+                glm::vec3 low(channel.values[kept[0]]), high = low;
+                for (size_t i : kept) {
+                    low = glm::min(low, glm::vec3(channel.values[i]));
+                    high = glm::max(high, glm::vec3(channel.values[i]));
+                }
+                for (int k = 0; k < 3; k++) {
+                    range.min[k] = low[k];
+                    range.extent[k] = high[k] - low[k];
+                }
+            }
+            out.ranges[c].push_back(range);
+
+            int32_t due = -1;
+            for (size_t i : kept) {
+                PackedKey key;
+                if (c == ROTATION_CHANNEL) {
+                    key = packRotation(channel.values[i], track);
+                } else {
+                    key.track = track;
+                    for (int k = 0; k < 3; k++) {
+                        key.value[k] = range.extent[k] > 0.0f ? quantize((channel.values[i][k] - range.min[k]) / range.extent[k]) : 0;
+                    }
+                }
+                key.time = quantizeTime(channel.times[i]);
+                streams[c].push_back({due, key});
+                due = key.time;
+            }
+        }
+    }
+
+    for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+        std::stable_sort(streams[c].begin(), streams[c].end(),
+                         [](const StreamKey& a, const StreamKey& b) { return a.due < b.due; });
+        out.keys[c].reserve(streams[c].size());
+        for (auto& entry : streams[c]) out.keys[c].push_back(entry.key);
+    }
+    return out;
+}
+
+void ClipCompressionStats::add(const ClipCompressionStats& o) {
+    rawBytes += o.rawBytes;
+    compressedBytes += o.compressedBytes;
+    rawKeys += o.rawKeys;
+    compressedKeys += o.compressedKeys;
+    maxError = std::max(maxError, o.maxError);
+    tolerance = std::max(tolerance, o.tolerance);
+    rawSampleUs += o.rawSampleUs;
+    compressedSampleUs += o.compressedSampleUs;
+}
+
+ClipCompressionStats measureCompression(const Skeleton& skeleton, const AnimationClip& raw,
+                                        const CompressedClip& compressed, size_t samples) {
+    ClipCompressionStats stats;
+    stats.rawBytes = rawBytes(raw);
+    stats.compressedBytes = compressed.bytes();
+    for (auto& track : raw.tracks) stats.rawKeys += track.translations.size() + track.rotations.size() + track.scales.size();
+    stats.compressedKeys = compressed.keyCount();
+    float size = skeletonSize(skeleton);
+    stats.tolerance = ANIMATION_TOLERANCE * size;
+    if (skeleton.joints.empty() || samples == 0) return stats;
+
+    // Timed apart from the comparison, so neither run pays for the other
+    size_t count = skeleton.joints.size();
+    std::vector<JointPose> rawPose(count * samples), compressedPose(count * samples);
+    auto timeAt = [&](size_t i) { return raw.duration * (float)i / (float)samples; };
+    using clock = std::chrono::steady_clock;
+    auto us = [](clock::time_point from, clock::time_point to) {
+        return std::chrono::duration<double, std::micro>(to - from).count();
+    };
+
+    auto start = clock::now();
+    for (size_t i = 0; i < samples; i++) samplePose(skeleton, raw, timeAt(i), &rawPose[i * count]);
+    auto rawDone = clock::now();
+    ClipCursor cursor;
+    for (size_t i = 0; i < samples; i++) sampleClip(skeleton, compressed, cursor, timeAt(i), &compressedPose[i * count]);
+    auto compressedDone = clock::now();
+    stats.rawSampleUs = us(start, rawDone) / samples;
+    stats.compressedSampleUs = us(rawDone, compressedDone) / samples;
+
+    float distance = ANIMATION_ERROR_DISTANCE * size;
+    for (size_t i = 0; i < rawPose.size(); i++) {
+        const JointPose& a = rawPose[i];
+        const JointPose& b = compressedPose[i];
+        auto vec = [](const float* v) { return glm::vec4(v[0], v[1], v[2], v[3]); };
+        stats.maxError = std::max(stats.maxError, boneSpaceError(vec(a.translation), vec(b.translation), TRANSLATION_CHANNEL, distance));
+        stats.maxError = std::max(stats.maxError, boneSpaceError(vec(a.rotation), vec(b.rotation), ROTATION_CHANNEL, distance));
+        stats.maxError = std::max(stats.maxError, boneSpaceError(vec(a.scale), vec(b.scale), SCALE_CHANNEL, distance));
+    }
+    return stats;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "animation.hpp"
+
+#include <cstddef>
+
+#define ANIMATION_TOLERANCE 0.0002f         // largest error a dropped key may cause, relative to the skeleton's size
+#define ANIMATION_ERROR_DISTANCE 0.1f       // rotation and scale errors are measured this far from the joint, same units
+
+// Keyframe reduction and quantization. Each channel keeps only the keys
+// linear interpolation cannot reproduce within the tolerance, measured in
+// the joint's own space: translation directly, rotation and scale as the
+// displacement of a point ANIMATION_ERROR_DISTANCE from the joint. Channels a
+// track lacks get the bind pose as a single key.
+CompressedClip compressClip(const Skeleton& skeleton, const AnimationClip& clip);
+
+struct ClipCompressionStats {
+    size_t rawBytes = 0;
+    size_t compressedBytes = 0;
+    size_t rawKeys = 0;
+    size_t compressedKeys = 0;
+    float maxError = 0.0f;          // bone space, same units as the skeleton
+    float tolerance = 0.0f;         // what compressClip aimed for
+    double rawSampleUs = 0.0;       // per pose
+    double compressedSampleUs = 0.0;
+
+    void add(const ClipCompressionStats& o);
+};
+
+// Plays both versions forward over `samples` evenly spaced times, as the
+// renderer would, comparing the poses and timing the two samplers
+ClipCompressionStats measureCompression(const Skeleton& skeleton, const AnimationClip& raw,
+                                        const CompressedClip& compressed, size_t samples = 240);
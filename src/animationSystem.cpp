@@ -0,0 +1,159 @@
+#include "animationSystem.hpp"
+#include "threadPool.hpp"
+#include "uniformBuffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // Every bind covers a whole block, so a slice may run past its instance's
+    // bones into the next one; the shader never reads those entries. Slices
+    // are whole matrices apart, since the GL alignment is a power of two.
+    const size_t PALETTE_BLOCK_BYTES = MAX_BONES * sizeof(JointMatrix);
+
+    size_t paletteAlignment() {
+        static size_t alignment = 0;
+        if (!alignment) {
+            GLint value = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+            alignment = value > 0 ? (size_t)value : 256;
+        }
+        return alignment;
+    }
+}
+
+AnimationHandle AnimationSystem::create(std::shared_ptr<const Skeleton> skeleton,
+                                        std::vector<std::shared_ptr<const CompressedClip>> clips) {
+    if (!skeleton || clips.empty()) return 0;
+
+    AnimationHandle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        handle = (AnimationHandle)instances.size();
+        instances.emplace_back();
+    }
+
+    Instance& instance = instances[handle];
+    instance = Instance();
+    instance.pose.resize(skeleton->joints.size());
+    instance.blendPose.resize(skeleton->joints.size());
+    instance.globals.resize(skeleton->joints.size());
+    instance.skeleton = std::move(skeleton);
+    instance.clips = std::move(clips);
+    instance.live = true;
+    layoutChanged = true;
+    return handle;
+}
+
+void AnimationSystem::release(AnimationHandle handle) {
+    Instance* instance = find(handle);
+    if (!instance) return;
+    *instance = Instance();
+    freeHandles.push_back(handle);
+    layoutChanged = true;
+}
+
+void AnimationSystem::play(AnimationHandle handle, size_t clip, float fade) {
+    Instance* instance = find(handle);
+    if (!instance || clip >= instance->clips.size() || clip == instance->clip) return;
+    instance->previous = instance->clip;
+    instance->previousTime = instance->time;
+    std::swap(instance->previousCursor, instance->cursor);
+    instance->clip = clip;
+    instance->time = 0.0f;
+    instance->fade = instance->fadeLength = std::max(fade, 0.0f);
+}
+
+void AnimationSystem::setSpeed(AnimationHandle handle, float speed) {
+    if (Instance* instance = find(handle)) instance->speed = speed;
+}
+
+void AnimationSystem::setTime(AnimationHandle handle, float seconds) {
+    if (Instance* instance = find(handle)) instance->time = seconds;
+}
+
+void AnimationSystem::evaluate(Instance& instance, float dt) {
+    const Skeleton& skeleton = *instance.skeleton;
+    instance.time += dt * instance.speed;
+    sampleClip(skeleton, *instance.clips[instance.clip], instance.cursor, instance.time, instance.pose.data());
+
+    if (instance.fade > 0.0f) {
+        instance.previousTime += dt * instance.speed;
+        instance.fade = std::max(instance.fade - dt, 0.0f);
+        sampleClip(skeleton, *instance.clips[instance.previous], instance.previousCursor, instance.previousTime,
+                   instance.blendPose.data());
+        float weight = instance.fadeLength > 0.0f ? 1.0f - instance.fade / instance.fadeLength : 1.0f;
+        blendPoses(instance.blendPose.data(), instance.pose.data(), weight, instance.pose.size(), instance.pose.data());
+    }
+
+    // straight into the upload, the slices never overlap in what is written
+    JointMatrix* palette = staging.data() + instance.paletteOffset / sizeof(JointMatrix);
+    buildPalette(skeleton, instance.pose.data(), instance.globals.data(), palette);
+}
+
+void AnimationSystem::update(float dt) {
+    auto start = std::chrono::steady_clock::now();
+    AnimationStats stats;
+
+    // Lay the palettes out first, so the jobs only write their own slice
+    std::vector<Instance*> live;
+    size_t alignment = paletteAlignment();
+    size_t bytes = 0;
+    for (auto& instance : instances) {
+        if (!instance.live) continue;
+        size_t boneCount = std::min(instance.skeleton->boneCount(), (size_t)MAX_BONES);
+        instance.paletteOffset = bytes;
+        bytes += (boneCount * sizeof(JointMatrix) + alignment - 1) / alignment * alignment;
+        live.push_back(&instance);
+        stats.bones += boneCount;
+    }
+    stats.instances = live.size();
+    lastStats = stats;
+    if (live.empty()) return;
+
+    // Bones with no node keep the identity; the tail lets the last slice bind a whole block
+    size_t total = bytes + PALETTE_BLOCK_BYTES;
+    if (layoutChanged || staging.size() * sizeof(JointMatrix) != total) {
+        staging.assign(total / sizeof(JointMatrix), identityMatrix());
+        layoutChanged = false;
+    }
+
+    size_t jobs = (live.size() + ANIMATION_JOB_INSTANCES - 1) / ANIMATION_JOB_INSTANCES;
+    ThreadPool::shared().parallelFor(jobs, [&](size_t job) {
+        size_t end = std::min((job + 1) * ANIMATION_JOB_INSTANCES, live.size());
+        for (size_t i = job * ANIMATION_JOB_INSTANCES; i < end; i++) evaluate(*live[i], dt);
+    });
+
+    if (!paletteBuffer) glGenBuffers(1, &paletteBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, paletteBuffer);
+    // orphans last frame's palettes, so no draw still reading them stalls the write
+    paletteCapacity = std::max(paletteCapacity, total);
+    glBufferData(GL_UNIFORM_BUFFER, paletteCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, total, staging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    lastStats.uploadBytes = total;
+    lastStats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AnimationSystem::bind(AnimationHandle handle) {
+    Instance* instance = find(handle);
+    if (!instance || !paletteBuffer) return;
+    glBindBufferRange(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, paletteBuffer, instance->paletteOffset, PALETTE_BLOCK_BYTES);
+}
+
+void AnimationSystem::cleanup() {
+    if (paletteBuffer) glDeleteBuffers(1, &paletteBuffer);
+    paletteBuffer = 0;
+    paletteCapacity = 0;
+    staging.clear();
+    instances.assign(1, Instance());
+    freeHandles.clear();
+}
+
+AnimationSystem::Instance* AnimationSystem::find(AnimationHandle handle) {
+    if (handle == 0 || handle >= instances.size() || !instances[handle].live) return nullptr;
+    return &instances[handle];
+}
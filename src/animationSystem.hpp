@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "animation.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define ANIMATION_JOB_INSTANCES 16      // instances per pool job
+#define ANIMATION_FADE_SECONDS 0.2f     // default cross-fade when switching clips
+
+// 0 is never a valid instance
+using AnimationHandle = uint32_t;
+
+struct AnimationStats {
+    size_t instances = 0;
+    size_t bones = 0;
+    size_t uploadBytes = 0;
+    double updateMs = 0.0;
+};
+
+// Every animated instance in one place. update() samples, blends and walks
+// the hierarchy of all of them on the thread pool, then uploads every palette
+// in one buffer write; bind() points the BonePalette block at one instance's
+// slice before its draw.
+class AnimationSystem {
+public:
+    static AnimationHandle create(std::shared_ptr<const Skeleton> skeleton,
+                                  std::vector<std::shared_ptr<const CompressedClip>> clips);
+    static void release(AnimationHandle handle);
+
+    // Switches clip, cross-fading from the current pose over `fade` seconds
+    static void play(AnimationHandle handle, size_t clip, float fade = ANIMATION_FADE_SECONDS);
+    static void setSpeed(AnimationHandle handle, float speed);
+    static void setTime(AnimationHandle handle, float seconds);
+
+    // Advances every instance by `dt`; call once per frame on the GL thread
+    static void update(float dt);
+    static void bind(AnimationHandle handle);
+
+    static const AnimationStats& stats() { return lastStats; }
+    static void cleanup();
+
+private:
+    struct Instance {
+        std::shared_ptr<const Skeleton> skeleton;
+        std::vector<std::shared_ptr<const CompressedClip>> clips;
+        size_t clip = 0;
+        size_t previous = 0;
+        float time = 0.0f;
+        float previousTime = 0.0f;
+        float fade = 0.0f;          // seconds left of the cross-fade
+        float fadeLength = 0.0f;
+        float speed = 1.0f;
+        size_t paletteOffset = 0;   // bytes into the palette buffer
+        bool live = false;
+
+        ClipCursor cursor;
+        ClipCursor previousCursor;
+
+        // Scratch, reused every frame
+        std::vector<JointPose> pose;
+        std::vector<JointPose> blendPose;
+        std::vector<JointMatrix> globals;
+    };
+
+    inline static std::vector<Instance> instances = std::vector<Instance>(1);   // slot 0 unused
+    inline static std::vector<AnimationHandle> freeHandles;
+    inline static std::vector<JointMatrix> staging;
+    inline static bool layoutChanged = true;
+    inline static GLuint paletteBuffer = 0;
+    inline static size_t paletteCapacity = 0;
+    inline static AnimationStats lastStats;
+
+    static Instance* find(AnimationHandle handle);
+    static void evaluate(Instance& instance, float dt);
+};
@@ -0,0 +1,245 @@
+#include "blockCompress.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    uint16_t packRGB565(const float* c) {
+        int r = std::clamp((int)std::lround(c[0] * 31.0f / 255.0f), 0, 31);
+        int g = std::clamp((int)std::lround(c[1] * 63.0f / 255.0f), 0, 63);
+        int b = std::clamp((int)std::lround(c[2] * 31.0f / 255.0f), 0, 31);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    // Expands like the hardware does: replicate the top bits into the low ones
+    void unpackRGB565(uint16_t c, float* out) {
+        int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        out[0] = (float)((r << 3) | (r >> 2));
+        out[1] = (float)((g << 2) | (g >> 4));
+        out[2] = (float)((b << 3) | (b >> 2));
+    }
+
+    float distance2(const float* a, const unsigned char* b) {
+        float dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // Picks the nearest of the four palette entries for each texel; returns the packed indices
+    uint32_t colorIndices(const unsigned char* rgba, uint16_t c0, uint16_t c1, float* error) {
+        float palette[4][3];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int i = 0; i < 3; i++) {
+            palette[2][i] = (2.0f * palette[0][i] + palette[1][i]) / 3.0f;
+            palette[3][i] = (palette[0][i] + 2.0f * palette[1][i]) / 3.0f;
+        }
+
+        uint32_t indices = 0;
+        float total = 0.0f;
+        for (int p = 0; p < 16; p++) {
+            int best = 0;
+            float bestDist = distance2(palette[0], rgba + p * 4);
+            for (int i = 1; i < 4; i++) {
+                float d = distance2(palette[i], rgba + p * 4);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = i;
+                }
+            }
+            indices |= (uint32_t)best << (p * 2);
+            total += bestDist;
+        }
+        if (error) *error = total;
+        return indices;
+    }
+
+    // Least-squares endpoints for a fixed index assignment (4-color mode)
+    bool refineEndpoints(const unsigned char* rgba, uint32_t indices, float* e0, float* e1) {
+        const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0, ab = 0, bb = 0;
+        float ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+        for (int p = 0; p < 16; p++) {
+            float a = weights[(indices >> (p * 2)) & 3];
+            float b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int i = 0; i < 3; i++) {
+                ax[i] += a * rgba[p * 4 + i];
+                bx[i] += b * rgba[p * 4 + i];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f) return false;
+        for (int i = 0; i < 3; i++) {
+            e0[i] = std::clamp((ax[i] * bb - bx[i] * ab) / det, 0.0f, 255.0f);
+            e1[i] = std::clamp((bx[i] * aa - ax[i] * ab) / det, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    void writeColorBlock(uint16_t c0, uint16_t c1, uint32_t indices, unsigned char* out) {
+        out[0] = (unsigned char)(c0 & 0xFF);
+        out[1] = (unsigned char)(c0 >> 8);
+        out[2] = (unsigned char)(c1 & 0xFF);
+        out[3] = (unsigned char)(c1 >> 8);
+        for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(indices >> (i * 8));
+    }
+
+    // Orders endpoints so the block decodes in 4-color mode; BC3 always
+    // does, and BC1 would otherwise switch to 3-color + black
+    void encodeColor(const unsigned char* rgba, const float* e0, const float* e1, unsigned char* out, float* error) {
+        uint16_t c0 = packRGB565(e0);
+        uint16_t c1 = packRGB565(e1);
+        if (c0 < c1) std::swap(c0, c1);
+
+        if (c0 == c1) {
+            if (error) {
+                float flat[3];
+                unpackRGB565(c0, flat);
+                *error = 0.0f;
+                for (int p = 0; p < 16; p++) *error += distance2(flat, rgba + p * 4);
+            }
+            writeColorBlock(c0, c1, 0, out);
+            return;
+        }
+        writeColorBlock(c0, c1, colorIndices(rgba, c0, c1, error), out);
+    }
+}
+
+void encodeBC1Block(const unsigned char* rgba, unsigned char* out) {
+    // Principal axis of the block's colors by power iteration
+    float mean[3] = {0, 0, 0};
+    for (int p = 0; p < 16; p++) {
+        for (int i = 0; i < 3; i++) mean[i] += rgba[p * 4 + i];
+    }
+    for (int i = 0; i < 3; i++) mean[i] /= 16.0f;
+
+    float cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int p = 0; p < 16; p++) {
+        float r = rgba[p * 4] - mean[0], g = rgba[p * 4 + 1] - mean[1], b = rgba[p * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 8; iter++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = std::max({std::fabs(x), std::fabs(y), std::fabs(z)});
+        if (len < 1e-6f) break;
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+
+    float minT = 1e30f, maxT = -1e30f;
+    for (int p = 0; p < 16; p++) {
+        float t = (rgba[p * 4] - mean[0]) * axis[0] + (rgba[p * 4 + 1] - mean[1]) * axis[1] +
+                  (rgba[p * 4 + 2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    // Pull the endpoints in slightly; extremes are rarely the best fit
+    float lenSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float inset = (maxT - minT) / 16.0f;
+    float e0[3], e1[3];
+    for (int i = 0; i < 3; i++) {
+        e0[i] = std::clamp(mean[i] + axis[i] * (maxT - inset) / std::max(lenSq, 1e-6f), 0.0f, 255.0f);
+        e1[i] = std::clamp(mean[i] + axis[i] * (minT + inset) / std::max(lenSq, 1e-6f), 0.0f, 255.0f);
+    }
+
+    float error = 0.0f;
+    encodeColor(rgba, e0, e1, out, &error);
+
+    // One least-squares pass over the chosen indices; keep it only if it helps
+    uint32_t indices = out[4] | (out[5] << 8) | (out[6] << 16) | ((uint32_t)out[7] << 24);
+    float r0[3], r1[3];
+    if (indices != 0 && refineEndpoints(rgba, indices, r0, r1)) {
+        unsigned char refined[8];
+        float refinedError = 0.0f;
+        encodeColor(rgba, r0, r1, refined, &refinedError);
+        if (refinedError < error) std::memcpy(out, refined, 8);
+    }
+}
+
+void encodeBC4Block(const unsigned char* rgba, int channel, unsigned char* out) {
+    int lo = 255, hi = 0;
+    for (int p = 0; p < 16; p++) {
+        lo = std::min(lo, (int)rgba[p * 4 + channel]);
+        hi = std::max(hi, (int)rgba[p * 4 + channel]);
+    }
+
+    // hi > lo selects the 8-value mode: two endpoints plus six interpolants
+    out[0] = (unsigned char)hi;
+    out[1] = (unsigned char)lo;
+    std::memset(out + 2, 0, 6);
+    if (hi == lo) return;
+
+    int palette[8];
+    palette[0] = hi;
+    palette[1] = lo;
+    for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * hi + i * lo) / 7;
+
+    uint64_t bits = 0;
+    for (int p = 0; p < 16; p++) {
+        int value = rgba[p * 4 + channel];
+        int best = 0;
+        int bestDist = 256;
+        for (int i = 0; i < 8; i++) {
+            int d = std::abs(palette[i] - value);
+            if (d < bestDist) {
+                bestDist = d;
+                best = i;
+            }
+        }
+        bits |= (uint64_t)best << (p * 3);
+    }
+    for (int i = 0; i < 6; i++) out[2 + i] = (unsigned char)(bits >> (i * 8));
+}
+
+void encodeBC3Block(const unsigned char* rgba, unsigned char* out) {
+    encodeBC4Block(rgba, 3, out);
+    encodeBC1Block(rgba, out + 8);
+}
+
+void encodeBC5Block(const unsigned char* rgba, unsigned char* out) {
+    encodeBC4Block(rgba, 0, out);
+    encodeBC4Block(rgba, 1, out + 8);
+}
+
+std::vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, BlockFormat format) {
+    if (format == BlockFormat::RGBA8) return std::vector<unsigned char>(rgba, rgba + (size_t)width * height * 4);
+
+    std::vector<unsigned char> result(compressedLevelSize(format, width, height));
+    size_t stride = blockBytes(format);
+    int blocksX = std::max(1, (width + 3) / 4);
+    int blocksY = std::max(1, (height + 3) / 4);
+
+    unsigned char block[16 * 4];
+    unsigned char* out = result.data();
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            for (int y = 0; y < 4; y++) {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+
+            switch (format) {
+                case BlockFormat::BC1: encodeBC1Block(block, out); break;
+                case BlockFormat::BC3: encodeBC3Block(block, out); break;
+                case BlockFormat::BC4: encodeBC4Block(block, 0, out); break;
+                case BlockFormat::BC5: encodeBC5Block(block, out); break;
+                case BlockFormat::RGBA8: break;
+            }
+            out += stride;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "textureContainer.hpp"
+
+#include <vector>
+
+// CPU block-compression encoders, so textures can be baked without a GPU.
+// Blocks are 4x4 RGBA8 texels, row-major; output follows the BCn layouts
+// GL expects for S3TC (BC1/BC3) and RGTC (BC4/BC5).
+void encodeBC1Block(const unsigned char* rgba, unsigned char* out);
+void encodeBC3Block(const unsigned char* rgba, unsigned char* out);
+// channel: which of the four RGBA bytes to encode
+void encodeBC4Block(const unsigned char* rgba, int channel, unsigned char* out);
+void encodeBC5Block(const unsigned char* rgba, unsigned char* out);
+
+// Compresses a whole RGBA8 image; partial edge blocks repeat the last texel.
+// RGBA8 returns a plain copy.
+std::vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, BlockFormat format);
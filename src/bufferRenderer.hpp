@@ -3,6 +3,9 @@
 #include <glad/glad.h>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+
+#include "glState.hpp"
 
 struct VertexAttrib {
     GLuint index;
@@ -22,19 +25,26 @@ public:
 
     void cleanup() const {
         glDeleteVertexArrays(1, &vao);
+        GLState::forgetVertexArray(vao);
         glDeleteBuffers(1, &vbo);
         glDeleteBuffers(1, &ebo);
+        if (instanceVbo) glDeleteBuffers(1, &instanceVbo);
     }
 
-    void bind() const { glBindVertexArray(vao); }
-    void unbind() const { glBindVertexArray(0); }
+    void bind() const { GLState::bindVertexArray(vao); }
+    void unbind() const { GLState::bindVertexArray(0); }
 
     template<typename T>
     void setVertices(const T* data, size_t count, GLenum usage = GL_STATIC_DRAW) {
+        setVertexData(data, count, sizeof(T), usage);
+    }
+
+    // Untyped form, for streams whose layout is only known at runtime
+    void setVertexData(const void* data, size_t count, size_t stride, GLenum usage = GL_STATIC_DRAW) {
         vertexCount = count;
         bind();
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, count * sizeof(T), data, usage);
+        glBufferData(GL_ARRAY_BUFFER, count * stride, data, usage);
     }
 
     template<typename T>
@@ -42,9 +52,11 @@ public:
         setVertices(data.data(), data.size(), usage);
     }
 
+    // 8-, 16- or 32-bit indices; the draw calls follow the element size
     template<typename T>
     void setIndices(const T* data, size_t count, GLenum usage = GL_STATIC_DRAW) {
         indexCount = count;
+        indexType = indexTypeFor(sizeof(T));
         hasEBO = true;
         bind();
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -56,6 +68,35 @@ public:
         setIndices(data.data(), data.size(), usage);
     }
 
+    // --- MAPPED UPLOAD: allocate the store and write into driver memory
+    // directly (e.g. decompress into it); each map is paired with an unmap,
+    // which returns false if the contents were lost and must be re-sent
+    void* mapVertices(size_t count, size_t elementSize) {
+        vertexCount = count;
+        bind();
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        return mapStore(GL_ARRAY_BUFFER, count * elementSize);
+    }
+
+    bool unmapVertices() {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+    }
+
+    void* mapIndices(size_t count, size_t elementSize) {
+        indexCount = count;
+        indexType = indexTypeFor(elementSize);
+        hasEBO = true;
+        bind();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        return mapStore(GL_ELEMENT_ARRAY_BUFFER, count * elementSize);
+    }
+
+    bool unmapIndices() {
+        bind();
+        return glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE;
+    }
+
     // --- AUTOMATIC MODE (unchanged)
     void addAttrib(GLuint index, GLint size, GLenum type, GLboolean normalized = GL_FALSE) {
         size_t offset = autoStride;
@@ -71,6 +112,57 @@ public:
     // Set stride manually when using structs
     void setStride(size_t s) { totalStride = s; }
 
+    // --- INSTANCING: per-instance attributes from a second buffer (divisor 1)
+    void addInstanceAttrib(GLuint index, GLint size, GLenum type, size_t offset, GLboolean normalized = GL_FALSE) {
+        instanceAttribs.push_back({index, size, type, normalized, offset});
+    }
+
+    void linkInstances(size_t stride) {
+        if (!instanceVbo) glGenBuffers(1, &instanceVbo);
+        instanceStride = stride;
+        bind();
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        for (auto& a : instanceAttribs) {
+            glEnableVertexAttribArray(a.index);
+            if (isInteger(a.type)) {
+                glVertexAttribIPointer(a.index, a.size, a.type, stride, (void*)a.offset);
+            } else {
+                glVertexAttribPointer(a.index, a.size, a.type, a.normalized, stride, (void*)a.offset);
+            }
+            glVertexAttribDivisor(a.index, 1);
+        }
+        unbind();
+    }
+
+    // Orphans and refills the instance buffer; meant for per-frame data
+    template<typename T>
+    void setInstances(const T* data, size_t count) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(T), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(T), data);
+    }
+
+    template<typename T>
+    void setInstances(const std::vector<T>& data) {
+        setInstances(data.data(), data.size());
+    }
+
+    // Identifies the vertex format, so buffers with the same attribute setup compare equal
+    uint64_t layoutKey() const {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t v) { hash = (hash ^ v) * 1099511628211ull; };
+        for (auto& a : attribs) {
+            mix(a.index); mix(a.size); mix(a.type); mix(a.normalized); mix(a.offset);
+        }
+        mix((totalStride == 0) ? autoStride : totalStride);
+        for (auto& a : instanceAttribs) {
+            mix(a.index); mix(a.size); mix(a.type); mix(a.normalized); mix(a.offset);
+        }
+        mix(instanceStride);
+        mix(hasEBO);
+        return hash;
+    }
+
     // Link attributes
     void link() {
         bind();
@@ -80,6 +172,11 @@ public:
 
         for (auto& a : attribs) {
             glEnableVertexAttribArray(a.index);
+            // Unnormalized integer attributes reach the shader as ints (ivec4/uvec4)
+            if (isInteger(a.type) && !a.normalized) {
+                glVertexAttribIPointer(a.index, a.size, a.type, stride, (void*)a.offset);
+                continue;
+            }
             glVertexAttribPointer(
                 a.index,
                 a.size,
@@ -95,25 +192,76 @@ public:
     void draw() const {
         bind();
         if (hasEBO) {
-            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
         } else {
             glDrawArrays(GL_TRIANGLES, 0, vertexCount);
         }
-        unbind();
+    }
+
+    // --- SHARED STORES: several meshes in one buffer pair, addressed by
+    // index offset (elements) and base vertex
+    void drawRange(size_t count, size_t firstIndex, GLint baseVertex) const {
+        bind();
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)count, indexType,
+                                 (void*)(firstIndex * indexSize()), baseVertex);
+    }
+
+    void multiDraw(const GLsizei* counts, const void* const* byteOffsets, const GLint* baseVertices, size_t draws) const {
+        bind();
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, indexType, byteOffsets, (GLsizei)draws, baseVertices);
+    }
+
+    size_t indexSize() const { return indexType == GL_UNSIGNED_BYTE ? 1 : (indexType == GL_UNSIGNED_SHORT ? 2 : 4); }
+    GLuint vertexBuffer() const { return vbo; }
+    GLuint indexBuffer() const { return ebo; }
+
+    void drawInstanced(size_t instances) const {
+        bind();
+        if (hasEBO) {
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, (GLsizei)instances);
+        } else {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, (GLsizei)instances);
+        }
+    }
+
+    // One index range of the buffer, `instances` times
+    void drawRangeInstanced(size_t count, size_t firstIndex, size_t instances) const {
+        bind();
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)count, indexType, (void*)(firstIndex * indexSize()), (GLsizei)instances);
     }
 
 private:
     GLuint vao = 0, vbo = 0, ebo = 0;
 
     std::vector<VertexAttrib> attribs;
+    std::vector<VertexAttrib> instanceAttribs;
+    GLuint instanceVbo = 0;
+    size_t instanceStride = 0;
 
     size_t autoStride = 0;     // tightly packed mode
     size_t totalStride = 0;    // struct mode
 
     size_t vertexCount = 0;
     size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
     bool hasEBO = false;
 
+    static GLenum indexTypeFor(size_t elementSize) {
+        if (elementSize == 1) return GL_UNSIGNED_BYTE;
+        return elementSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    static void* mapStore(GLenum target, size_t bytes) {
+        glBufferData(target, bytes, nullptr, GL_STATIC_DRAW);
+        if (bytes == 0) return nullptr;
+        return glMapBufferRange(target, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    static bool isInteger(GLenum type) {
+        return type == GL_INT || type == GL_UNSIGNED_INT || type == GL_SHORT ||
+               type == GL_UNSIGNED_SHORT || type == GL_BYTE || type == GL_UNSIGNED_BYTE;
+    }
+
     size_t typeSize(GLenum type) const {
         switch (type) {
             case GL_FLOAT: return sizeof(float);
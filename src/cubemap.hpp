@@ -2,6 +2,7 @@
 
 #include "bufferRenderer.hpp"
 #include "shader.hpp"
+#include "glState.hpp"
 #include "./IO/camera.hpp"
 
 #include <glm/glm.hpp>
@@ -9,7 +10,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <glad/glad.h>
-#include <stb/stb_image.h>
+#include "textureLoader.hpp"
 
 #include <vector>
 #include <string>
@@ -68,6 +69,8 @@ public:
         br.link();
 
         cubemapTexture = loadCubemap(faces);
+        // Filter across face edges; without it the mips show seams
+        GLState::enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
         shader.use();
         shader.setInt(texName, 0);
@@ -79,48 +82,22 @@ public:
         shader.setInt(texName, id);
     }
 
-    void Draw(glm::mat4 view, glm::mat4 projection, Camera& camera) {
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+    // view/projection come from the FrameData block; skybox.vs strips the translation
+    void Draw() {
+        GLState::depthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
         shader.use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
         // skybox cube
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
         br.draw();
-        glDepthFunc(GL_LESS); // set depth function back to default
+        GLState::depthFunc(GL_LESS); // set depth function back to default
 
     }
 private:
     Shader& shader;
+    // Faces decode in parallel on worker threads (or come from the cubemap
+    // cache); until they are uploaded the cubemap samples as a 1x1 placeholder
     unsigned int loadCubemap(std::vector<std::string> faces) {
-        unsigned int textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-        stbi_set_flip_vertically_on_load(false);
-
-        int width, height, nrChannels;
-        for (unsigned int i = 0; i < faces.size(); i++) {
-            unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-            if (data) {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-                stbi_image_free(data);
-            } else {
-                std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-                stbi_image_free(data);
-            }
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-        stbi_set_flip_vertically_on_load(true);
-
-        return textureID;
+        return TextureLoader::loadCube(faces).id;
     }
     unsigned int cubemapTexture;
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Records the first N frame times and prints a summary once full, so
+// start-up hitches (first-draw compiles, late uploads) show up as spikes.
+class FrameTimeLog {
+public:
+    explicit FrameTimeLog(size_t frames = 120) : capacity(frames) {
+        times.reserve(frames);
+    }
+
+    void record(float seconds) {
+        if (times.size() >= capacity) return;
+        times.push_back(seconds * 1000.0f);
+        if (times.size() == capacity) report();
+    }
+
+    bool done() const { return times.size() >= capacity; }
+    const std::vector<float>& Times() const { return times; }
+
+    void report() const {
+        if (times.empty()) return;
+
+        std::vector<float> sorted = times;
+        std::sort(sorted.begin(), sorted.end());
+        float median = sorted[sorted.size() / 2];
+
+        float total = 0.0f;
+        size_t worst = 0;
+        unsigned int spikes = 0;
+        for (size_t i = 0; i < times.size(); i++) {
+            total += times[i];
+            if (times[i] > times[worst]) worst = i;
+            if (times[i] > median * 2.0f) spikes++;
+        }
+
+        std::cout << "First " << times.size() << " frames: avg " << total / times.size()
+                  << " ms, median " << median << " ms, max " << times[worst]
+                  << " ms (frame " << worst + 1 << "), " << spikes << " frames over 2x median" << std::endl;
+    }
+
+private:
+    size_t capacity;
+    std::vector<float> times;
+};
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <unordered_map>
 #include "shader.hpp"
+#include "glState.hpp"
 
 class Framebuffer {
 public:
@@ -24,11 +25,11 @@ public:
 
         // Generate framebuffer
         glGenFramebuffers(1, &framebuffer);
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        GLState::bindFramebuffer(framebuffer);
 
         // Generate texture
         glGenTextures(1, &textureColorbuffer);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        GLState::bindTexture(GL_TEXTURE_2D, textureColorbuffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
                      (int)width, (int)height,
                      0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
@@ -48,13 +49,13 @@ public:
         if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
             std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!\n";
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::bindFramebuffer(0);
     }
 
     void ResizeFrameBuffer(int w, int h) {
         width = w;
         height = h;
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        GLState::bindTexture(GL_TEXTURE_2D, textureColorbuffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
 
         glBindRenderbuffer(GL_RENDERBUFFER, rbo);
@@ -62,12 +63,12 @@ public:
     }
 
     void BindFrameBuffer() {
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        GLState::bindFramebuffer(framebuffer);
         glViewport(0, 0, width, height);
     }
 
     void UnbindFrameBuffer() {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::bindFramebuffer(0);
     }
 
     unsigned int Texture() {
@@ -78,6 +79,8 @@ public:
         // Cleanup GL objects
         glDeleteFramebuffers(1, &framebuffer);
         glDeleteTextures(1, &textureColorbuffer);
+        GLState::forgetFramebuffer(framebuffer);
+        GLState::forgetTexture(textureColorbuffer);
         glDeleteRenderbuffers(1, &rbo);
 
         // Remove from registry
@@ -0,0 +1,362 @@
+#include "geometryHeap.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+    void describe(BufferRenderer& buf, VertexFormat format) {
+        buf.setStride(vertexStride(format));
+
+        if (format != VertexFormat::Full) {
+            // 10:10:10:2 and half floats widen to vec3/vec4/vec2 in vertex fetch
+            buf.addAttribOffset(0, 3, GL_FLOAT,                 offsetof(PackedVertex, Position));
+            buf.addAttribOffset(1, 4, GL_INT_2_10_10_10_REV,    offsetof(PackedVertex, Normal), GL_TRUE);
+            buf.addAttribOffset(2, 2, GL_HALF_FLOAT,            offsetof(PackedVertex, TexCoords));
+            buf.addAttribOffset(3, 4, GL_INT_2_10_10_10_REV,    offsetof(PackedVertex, Tangent), GL_TRUE);
+            if (format == VertexFormat::PackedSkinned) {
+                buf.addAttribOffset(5, 4, GL_UNSIGNED_BYTE, offsetof(PackedSkinnedVertex, BoneIDs));           // ivec4
+                buf.addAttribOffset(6, 4, GL_UNSIGNED_BYTE, offsetof(PackedSkinnedVertex, Weights), GL_TRUE);  // vec4
+            }
+            return;
+        }
+
+        buf.addAttribOffset(0, 3, GL_FLOAT,  offsetof(Vertex, Position));     // vec3
+        buf.addAttribOffset(1, 3, GL_FLOAT,  offsetof(Vertex, Normal));       // vec3
+        buf.addAttribOffset(2, 2, GL_FLOAT,  offsetof(Vertex, TexCoords));    // vec2
+        buf.addAttribOffset(3, 3, GL_FLOAT,  offsetof(Vertex, Tangent));      // vec3
+        buf.addAttribOffset(4, 3, GL_FLOAT,  offsetof(Vertex, Bitangent));    // vec3
+        buf.addAttribOffset(5, 4, GL_INT,    offsetof(Vertex, m_BoneIDs));    // ivec4
+        buf.addAttribOffset(6, 4, GL_FLOAT,  offsetof(Vertex, m_Weights));    // vec4
+    }
+
+    // Heap writes go through the copy targets, so no VAO or draw binding is disturbed
+    void* mapRange(GLuint buffer, size_t offset, size_t bytes) {
+        if (bytes == 0) return nullptr;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+
+    bool unmapRange(GLuint buffer) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        return glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+    }
+
+    // Packed pools have no weights array, so a SKINNED program reads the
+    // generic attribute, (0,0,0,1) by default: zero it so the mesh stays put
+    void clearWeights(VertexFormat format) {
+        if (format == VertexFormat::Packed) glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    void writeRange(GLuint buffer, size_t offset, size_t bytes, const void* data) {
+        if (bytes == 0) return;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+    }
+}
+
+GeometryHandle GeometryHeap::allocate(VertexFormat format, size_t vertexCount, size_t indexCount, size_t indexSize) {
+    uint32_t poolIndex = poolFor(format, indexSize);
+    Pool& pool = *pools[poolIndex];
+    if (!reserve(pool, poolIndex, vertexCount, indexCount)) return 0;
+
+    Allocation allocation;
+    allocation.pool = poolIndex;
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+    allocation.live = true;
+    pool.vertices.allocate(vertexCount, allocation.firstVertex);
+    pool.indices.allocate(indexCount, allocation.firstIndex);
+
+    GeometryHandle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        allocations[handle] = allocation;
+    } else {
+        handle = (GeometryHandle)allocations.size();
+        allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void GeometryHeap::release(GeometryHandle handle) {
+    if (!find(handle)) return;
+    Allocation& allocation = allocations[handle];
+    Pool& pool = *pools[allocation.pool];
+    pool.vertices.free(allocation.firstVertex, allocation.vertexCount);
+    pool.indices.free(allocation.firstIndex, allocation.indexCount);
+    allocation.live = false;
+    freeHandles.push_back(handle);
+}
+
+void GeometryHeap::writeVertices(GeometryHandle handle, const void* data) {
+    const Allocation* a = find(handle);
+    if (!a) return;
+    const Pool& pool = *pools[a->pool];
+    writeRange(pool.buf.vertexBuffer(), a->firstVertex * pool.stride, a->vertexCount * pool.stride, data);
+}
+
+void GeometryHeap::writeIndices(GeometryHandle handle, const void* data) {
+    const Allocation* a = find(handle);
+    if (!a) return;
+    const Pool& pool = *pools[a->pool];
+    writeRange(pool.buf.indexBuffer(), a->firstIndex * pool.indexSize, a->indexCount * pool.indexSize, data);
+}
+
+void* GeometryHeap::mapVertices(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    if (!a) return nullptr;
+    const Pool& pool = *pools[a->pool];
+    return mapRange(pool.buf.vertexBuffer(), a->firstVertex * pool.stride, a->vertexCount * pool.stride);
+}
+
+bool GeometryHeap::unmapVertices(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    return a && unmapRange(pools[a->pool]->buf.vertexBuffer());
+}
+
+void* GeometryHeap::mapIndices(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    if (!a) return nullptr;
+    const Pool& pool = *pools[a->pool];
+    return mapRange(pool.buf.indexBuffer(), a->firstIndex * pool.indexSize, a->indexCount * pool.indexSize);
+}
+
+bool GeometryHeap::unmapIndices(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    return a && unmapRange(pools[a->pool]->buf.indexBuffer());
+}
+
+void GeometryHeap::draw(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    if (!a) return;
+    draw(handle, IndexRange{0, (uint32_t)a->indexCount});
+}
+
+void GeometryHeap::draw(GeometryHandle handle, IndexRange range) {
+    const Allocation* a = find(handle);
+    if (!a || !range.count || range.first + range.count > a->indexCount) return;
+    clearWeights(pools[a->pool]->format);
+    pools[a->pool]->buf.drawRange(range.count, a->firstIndex + range.first, (GLint)a->firstVertex);
+    triangles += range.count / 3;
+    draws++;
+}
+
+void GeometryHeap::drawMulti(const GeometryHandle* handles, size_t count) {
+    drawRanges(handles, nullptr, count);
+}
+
+// Without `ranges`, every allocation is drawn whole
+void GeometryHeap::drawRanges(const GeometryHandle* handles, const IndexRange* ranges, size_t count) {
+    drawCounts.clear();
+    drawOffsets.clear();
+    drawBaseVertices.clear();
+
+    const Pool* pool = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        const Allocation* a = find(handles[i]);
+        if (!a) continue;
+        IndexRange range = ranges ? ranges[i] : IndexRange{0, (uint32_t)a->indexCount};
+        if (!range.count || range.first + range.count > a->indexCount) continue;
+        if (!pool) pool = pools[a->pool].get();
+
+        drawCounts.push_back((GLsizei)range.count);
+        drawOffsets.push_back((const void*)((a->firstIndex + range.first) * pool->indexSize));
+        drawBaseVertices.push_back((GLint)a->firstVertex);
+        triangles += range.count / 3;
+    }
+    if (!pool) return;
+    clearWeights(pool->format);
+    pool->buf.multiDraw(drawCounts.data(), drawOffsets.data(), drawBaseVertices.data(), drawCounts.size());
+    draws++;
+}
+
+uint32_t GeometryHeap::pool(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    return a ? a->pool : ~0u;
+}
+
+uint64_t GeometryHeap::layoutKey(GeometryHandle handle) {
+    const Allocation* a = find(handle);
+    return a ? pools[a->pool]->buf.layoutKey() : 0;
+}
+
+void GeometryHeap::compact() {
+    for (uint32_t i = 0; i < pools.size(); i++) compact(i);
+}
+
+GeometryHeapStats GeometryHeap::stats() {
+    GeometryHeapStats s;
+    s.pools = pools.size();
+    s.allocations = allocations.size() - 1 - freeHandles.size();
+    for (auto& pool : pools) {
+        s.usedBytes += pool->vertices.allocated() * pool->stride + pool->indices.allocated() * pool->indexSize;
+        s.capacityBytes += pool->vertices.capacity() * pool->stride + pool->indices.capacity() * pool->indexSize;
+    }
+    s.grows = grows;
+    s.compactions = compactions;
+    return s;
+}
+
+void GeometryHeap::cleanup() {
+    for (auto& pool : pools) pool->buf.cleanup();
+    pools.clear();
+    allocations.assign(1, Allocation());
+    freeHandles.clear();
+}
+
+uint32_t GeometryHeap::poolFor(VertexFormat format, size_t indexSize) {
+    for (uint32_t i = 0; i < pools.size(); i++) {
+        if (pools[i]->format == format && pools[i]->indexSize == indexSize) return i;
+    }
+
+    auto pool = std::make_unique<Pool>();
+    pool->format = format;
+    pool->stride = vertexStride(format);
+    pool->indexSize = indexSize;
+
+    size_t vertexCapacity = GEOMETRY_POOL_VERTEX_BYTES / pool->stride;
+    size_t indexCapacity = GEOMETRY_POOL_INDEX_BYTES / indexSize;
+    pool->vertices.grow(vertexCapacity);
+    pool->indices.grow(indexCapacity);
+
+    // Dynamic stores: ranges are rewritten as meshes come and go
+    pool->buf.setVertexData(nullptr, vertexCapacity, pool->stride, GL_DYNAMIC_DRAW);
+    if (indexSize == 2) {
+        pool->buf.setIndices((const unsigned short*)nullptr, indexCapacity, GL_DYNAMIC_DRAW);
+    } else {
+        pool->buf.setIndices((const unsigned int*)nullptr, indexCapacity, GL_DYNAMIC_DRAW);
+    }
+    describe(pool->buf, format);
+    pool->buf.link();
+
+    pools.push_back(std::move(pool));
+    return (uint32_t)(pools.size() - 1);
+}
+
+// Makes room for one more allocation: first by closing holes if that is
+// enough, otherwise by doubling the stores
+bool GeometryHeap::reserve(Pool& pool, uint32_t poolIndex, size_t vertexCount, size_t indexCount) {
+    size_t probe;
+    bool vertexFits = pool.vertices.allocate(vertexCount, probe);
+    if (vertexFits) pool.vertices.free(probe, vertexCount);
+    bool indexFits = pool.indices.allocate(indexCount, probe);
+    if (indexFits) pool.indices.free(probe, indexCount);
+    if (vertexFits && indexFits) return true;
+
+    if (pool.vertices.available() >= vertexCount && pool.indices.available() >= indexCount) {
+        compact(poolIndex);
+        return true;
+    }
+
+    size_t vertexCapacity = pool.vertices.capacity();
+    while (vertexCapacity - pool.vertices.allocated() < vertexCount) vertexCapacity *= 2;
+    size_t indexCapacity = pool.indices.capacity();
+    while (indexCapacity - pool.indices.allocated() < indexCount) indexCapacity *= 2;
+
+    // Grown stores keep their contents in place; compacting first puts the new space in one tail hole
+    compact(poolIndex);
+    if (vertexCapacity != pool.vertices.capacity()) {
+        resizeStore(pool.buf.vertexBuffer(), pool.vertices.allocated() * pool.stride, vertexCapacity * pool.stride);
+        pool.vertices.grow(vertexCapacity);
+    }
+    if (indexCapacity != pool.indices.capacity()) {
+        resizeStore(pool.buf.indexBuffer(), pool.indices.allocated() * pool.indexSize, indexCapacity * pool.indexSize);
+        pool.indices.grow(indexCapacity);
+    }
+    grows++;
+    return true;
+}
+
+void GeometryHeap::compact(uint32_t poolIndex) {
+    Pool& pool = *pools[poolIndex];
+    std::vector<Allocation*> live;
+    bool packed = true;
+    for (auto& a : allocations) {
+        if (!a.live || a.pool != poolIndex) continue;
+        live.push_back(&a);
+        // Live ranges that all fit in the allocated prefix leave no hole in it
+        packed = packed && a.firstVertex + a.vertexCount <= pool.vertices.allocated()
+                        && a.firstIndex + a.indexCount <= pool.indices.allocated();
+    }
+    if (packed) {
+        pool.vertices.reset(pool.vertices.allocated());
+        pool.indices.reset(pool.indices.allocated());
+        return;
+    }
+    std::sort(live.begin(), live.end(), [](const Allocation* a, const Allocation* b) { return a->firstVertex < b->firstVertex; });
+
+    // Pack into scratch buffers, then copy the packed prefix back. The
+    // buffer ids stay the same, so the pool's VAO needs no changes.
+    size_t vertexBytes = pool.vertices.allocated() * pool.stride;
+    size_t indexBytes = pool.indices.allocated() * pool.indexSize;
+    GLuint scratch[2];
+    glGenBuffers(2, scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scratch[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, nullptr, GL_STREAM_COPY);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scratch[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, nullptr, GL_STREAM_COPY);
+
+    size_t nextVertex = 0;
+    size_t nextIndex = 0;
+    for (Allocation* a : live) {
+        if (a->vertexCount) {
+            glBindBuffer(GL_COPY_READ_BUFFER, pool.buf.vertexBuffer());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, scratch[0]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, a->firstVertex * pool.stride,
+                                nextVertex * pool.stride, a->vertexCount * pool.stride);
+        }
+        if (a->indexCount) {
+            glBindBuffer(GL_COPY_READ_BUFFER, pool.buf.indexBuffer());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, scratch[1]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, a->firstIndex * pool.indexSize,
+                                nextIndex * pool.indexSize, a->indexCount * pool.indexSize);
+        }
+        a->firstVertex = nextVertex;
+        a->firstIndex = nextIndex;
+        nextVertex += a->vertexCount;
+        nextIndex += a->indexCount;
+    }
+
+    if (vertexBytes) {
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch[0]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.buf.vertexBuffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexBytes);
+    }
+    if (indexBytes) {
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch[1]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.buf.indexBuffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexBytes);
+    }
+    glDeleteBuffers(2, scratch);
+
+    pool.vertices.reset(nextVertex);
+    pool.indices.reset(nextIndex);
+    compactions++;
+}
+
+// Reallocates `buffer` at `newBytes`, keeping its first `usedBytes`
+void GeometryHeap::resizeStore(GLuint buffer, size_t usedBytes, size_t newBytes) {
+    GLuint scratch = 0;
+    if (usedBytes) {
+        glGenBuffers(1, &scratch);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+        glBufferData(GL_COPY_WRITE_BUFFER, usedBytes, nullptr, GL_STREAM_COPY);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    if (scratch) {
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+        glDeleteBuffers(1, &scratch);
+    }
+}
+
+const GeometryHeap::Allocation* GeometryHeap::find(GeometryHandle handle) {
+    if (handle == 0 || handle >= allocations.size() || !allocations[handle].live) return nullptr;
+    return &allocations[handle];
+}
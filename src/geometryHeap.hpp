@@ -0,0 +1,116 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "bufferRenderer.hpp"
+#include "rangeAllocator.hpp"
+#include "vertexFormat.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define GEOMETRY_POOL_VERTEX_BYTES (16u << 20)   // initial store per pool; pools double when full
+#define GEOMETRY_POOL_INDEX_BYTES (8u << 20)
+
+// 0 is never a valid allocation
+using GeometryHandle = uint32_t;
+
+// Part of an allocation's index list, in indices relative to its first one
+struct IndexRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+struct GeometryHeapStats {
+    size_t pools = 0;
+    size_t allocations = 0;
+    size_t usedBytes = 0;
+    size_t capacityBytes = 0;
+    unsigned int grows = 0;
+    unsigned int compactions = 0;
+};
+
+// Sub-allocates mesh geometry out of a few large buffers: one pool (VAO,
+// vertex buffer, index buffer) per vertex format and index width. Meshes in
+// a pool share every bind, so a whole run of them goes out as one
+// glMultiDrawElementsBaseVertex. Indices stay relative to their mesh; the
+// base vertex does the rest, which is also why compaction never rewrites them.
+class GeometryHeap {
+public:
+    static GeometryHandle allocate(VertexFormat format, size_t vertexCount, size_t indexCount, size_t indexSize);
+    static void release(GeometryHandle handle);
+
+    // Fill a fresh allocation, either from memory or by writing into a mapping
+    static void writeVertices(GeometryHandle handle, const void* data);
+    static void writeIndices(GeometryHandle handle, const void* data);
+    static void* mapVertices(GeometryHandle handle);
+    static bool unmapVertices(GeometryHandle handle);
+    static void* mapIndices(GeometryHandle handle);
+    static bool unmapIndices(GeometryHandle handle);
+
+    static void draw(GeometryHandle handle);
+    static void draw(GeometryHandle handle, IndexRange range);
+    // Every handle must come from the same pool (see pool())
+    static void drawMulti(const GeometryHandle* handles, size_t count);
+    static void drawRanges(const GeometryHandle* handles, const IndexRange* ranges, size_t count);
+
+    static uint32_t pool(GeometryHandle handle);
+    static uint64_t layoutKey(GeometryHandle handle);
+
+    // Packs every pool's live ranges to the front of its buffers
+    static void compact();
+
+    static GeometryHeapStats stats();
+    static void cleanup();
+
+    // Triangles and draw calls submitted during the previous frame
+    static size_t frameTriangles() { return lastFrameTriangles; }
+    static unsigned int frameDraws() { return lastFrameDraws; }
+    static void beginFrame() {
+        lastFrameTriangles = triangles;
+        lastFrameDraws = draws;
+        triangles = 0;
+        draws = 0;
+    }
+
+private:
+    struct Pool {
+        VertexFormat format = VertexFormat::Full;
+        size_t stride = 0;
+        size_t indexSize = 4;
+        BufferRenderer buf;
+        RangeAllocator vertices;    // in vertices
+        RangeAllocator indices;     // in indices
+    };
+
+    struct Allocation {
+        uint32_t pool = 0;
+        size_t firstVertex = 0;
+        size_t vertexCount = 0;
+        size_t firstIndex = 0;
+        size_t indexCount = 0;
+        bool live = false;
+    };
+
+    inline static std::vector<std::unique_ptr<Pool>> pools;
+    inline static std::vector<Allocation> allocations = std::vector<Allocation>(1);   // slot 0 unused
+    inline static std::vector<GeometryHandle> freeHandles;
+    inline static unsigned int grows = 0;
+    inline static unsigned int compactions = 0;
+    inline static size_t triangles = 0;
+    inline static unsigned int draws = 0;
+    inline static size_t lastFrameTriangles = 0;
+    inline static unsigned int lastFrameDraws = 0;
+
+    // Scratch for drawMulti
+    inline static std::vector<GLsizei> drawCounts;
+    inline static std::vector<const void*> drawOffsets;
+    inline static std::vector<GLint> drawBaseVertices;
+
+    static uint32_t poolFor(VertexFormat format, size_t indexSize);
+    static bool reserve(Pool& pool, uint32_t poolIndex, size_t vertexCount, size_t indexCount);
+    static void compact(uint32_t poolIndex);
+    static void resizeStore(GLuint buffer, size_t usedBytes, size_t newBytes);
+    static const Allocation* find(GeometryHandle handle);
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+// Entry points newer than the GL 3.3 core profile glad was generated for.
+// They are loaded by hand after gladLoadGLLoader and are only valid when the
+// matching flag is set; callers must keep a 3.3 fallback.
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// ARB_get_program_binary (core in 4.1)
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+// EXT_texture_compression_s3tc, plus the sRGB variants from EXT_texture_sRGB
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYEXTPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYEXTPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIEXTPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DEXTPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DEXTPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+
+class GLExtensions {
+public:
+    inline static bool programBinary = false;
+    inline static PFNGLGETPROGRAMBINARYEXTPROC GetProgramBinary = nullptr;
+    inline static PFNGLPROGRAMBINARYEXTPROC ProgramBinary = nullptr;
+    inline static PFNGLPROGRAMPARAMETERIEXTPROC ProgramParameteri = nullptr;
+
+    inline static bool parallelShaderCompile = false;
+    inline static PFNGLMAXSHADERCOMPILERTHREADSEXTPROC MaxShaderCompilerThreads = nullptr;
+
+    // ARB_texture_storage (core in 4.2): immutable, allocated-once textures
+    inline static bool textureStorage = false;
+    inline static PFNGLTEXSTORAGE2DEXTPROC TexStorage2D = nullptr;
+    inline static PFNGLTEXSTORAGE3DEXTPROC TexStorage3D = nullptr;
+
+    // BC1/BC3 uploads; BC4/BC5 (RGTC) are core since 3.0
+    inline static bool textureCompressionS3TC = false;
+    inline static bool textureCompressionS3TCsRGB = false;
+
+    static void load(GLADloadproc loader) {
+        if (versionAtLeast(4, 1) || has("GL_ARB_get_program_binary")) {
+            GetProgramBinary = (PFNGLGETPROGRAMBINARYEXTPROC)loader("glGetProgramBinary");
+            ProgramBinary = (PFNGLPROGRAMBINARYEXTPROC)loader("glProgramBinary");
+            ProgramParameteri = (PFNGLPROGRAMPARAMETERIEXTPROC)loader("glProgramParameteri");
+
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            programBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+        }
+
+        if (has("GL_KHR_parallel_shader_compile")) {
+            MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsKHR");
+        } else if (has("GL_ARB_parallel_shader_compile")) {
+            MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsARB");
+        }
+        if (MaxShaderCompilerThreads) {
+            // Let the driver use as many compiler threads as it likes
+            MaxShaderCompilerThreads(0xFFFFFFFFu);
+            parallelShaderCompile = true;
+        }
+
+        if (versionAtLeast(4, 2) || has("GL_ARB_texture_storage")) {
+            TexStorage2D = (PFNGLTEXSTORAGE2DEXTPROC)loader("glTexStorage2D");
+            TexStorage3D = (PFNGLTEXSTORAGE3DEXTPROC)loader("glTexStorage3D");
+            textureStorage = TexStorage2D && TexStorage3D;
+        }
+
+        textureCompressionS3TC = has("GL_EXT_texture_compression_s3tc");
+        textureCompressionS3TCsRGB = textureCompressionS3TC &&
+            (has("GL_EXT_texture_sRGB") || has("GL_EXT_texture_compression_s3tc_srgb"));
+    }
+
+    static bool has(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (ext && std::strcmp(ext, name) == 0) return true;
+        }
+        return false;
+    }
+
+    static bool versionAtLeast(int major, int minor) {
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+};
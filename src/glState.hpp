@@ -0,0 +1,150 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <utility>
+
+// Shadow copy of the GL state the renderer touches. Every bind goes through
+// here so calls that would not change anything are dropped before they reach
+// the driver. Anything that changes GL state behind our back (ImGui, raw GL
+// calls) must be followed by invalidate().
+class GLState {
+public:
+    static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+
+    static void useProgram(GLuint program) {
+        if (track(program == state.program)) return;
+        glUseProgram(program);
+        state.program = program;
+    }
+
+    static void bindVertexArray(GLuint vao) {
+        if (track(vao == state.vao)) return;
+        glBindVertexArray(vao);
+        state.vao = vao;
+    }
+
+    static void activeTexture(unsigned int unit) {
+        if (track(unit == state.activeUnit)) return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        state.activeUnit = unit;
+    }
+
+    static void bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+        GLuint* slot = textureSlot(unit, target);
+        if (slot && track(*slot == texture)) return;
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        if (slot) *slot = texture;
+    }
+
+    // Bind on whatever unit is active, for uploads and parameter setup
+    static void bindTexture(GLenum target, GLuint texture) {
+        bindTexture(state.activeUnit == UNKNOWN ? 0 : state.activeUnit, target, texture);
+    }
+
+    static void bindFramebuffer(GLuint framebuffer) {
+        if (track(framebuffer == state.framebuffer)) return;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        state.framebuffer = framebuffer;
+    }
+
+    static void depthFunc(GLenum func) {
+        if (track(func == state.depthFunc)) return;
+        glDepthFunc(func);
+        state.depthFunc = func;
+    }
+
+    static void enable(GLenum cap) { setCapability(cap, true); }
+    static void disable(GLenum cap) { setCapability(cap, false); }
+
+    // Deleted objects are unbound by GL, so the cache must forget them too
+    static void forgetProgram(GLuint program) {
+        if (state.program == program) state.program = 0;
+    }
+    static void forgetVertexArray(GLuint vao) {
+        if (state.vao == vao) state.vao = 0;
+    }
+    static void forgetFramebuffer(GLuint framebuffer) {
+        if (state.framebuffer == framebuffer) state.framebuffer = 0;
+    }
+    static void forgetTexture(GLuint texture) {
+        for (auto& unit : state.textures) {
+            for (auto& bound : unit) {
+                if (bound == texture) bound = 0;
+            }
+        }
+    }
+
+    static void invalidate() { state = State(); }
+
+    // Calls issued/skipped during the previous frame
+    static unsigned int frameIssued() { return lastFrame.first; }
+    static unsigned int frameSkipped() { return lastFrame.second; }
+    static void beginFrame() {
+        lastFrame = {issued, skipped};
+        issued = 0;
+        skipped = 0;
+    }
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER
+    static constexpr unsigned int TRACKED_TARGETS = 4;
+    static constexpr GLenum CAPABILITIES[] = {
+        GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_STENCIL_TEST,
+        GL_SCISSOR_TEST, GL_FRAMEBUFFER_SRGB, GL_TEXTURE_CUBE_MAP_SEAMLESS,
+    };
+    static constexpr unsigned int CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+    struct State {
+        State() {
+            for (auto& unit : textures) unit.fill(UNKNOWN);
+            capabilities.fill(-1);
+        }
+
+        GLuint program = UNKNOWN;
+        GLuint vao = UNKNOWN;
+        GLuint framebuffer = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        GLenum depthFunc = GL_NONE;
+        std::array<std::array<GLuint, TRACKED_TARGETS>, MAX_TEXTURE_UNITS> textures;
+        std::array<int, CAPABILITY_COUNT> capabilities;   // -1 unknown, 0 off, 1 on
+    };
+
+    inline static State state;
+    inline static unsigned int issued = 0;
+    inline static unsigned int skipped = 0;
+    inline static std::pair<unsigned int, unsigned int> lastFrame = {0, 0};
+
+    // Returns true (and counts a skip) when the call is redundant
+    static bool track(bool redundant) {
+        if (redundant) skipped++;
+        else issued++;
+        return redundant;
+    }
+
+    static GLuint* textureSlot(unsigned int unit, GLenum target) {
+        if (unit >= MAX_TEXTURE_UNITS) return nullptr;
+        switch (target) {
+            case GL_TEXTURE_2D: return &state.textures[unit][0];
+            case GL_TEXTURE_CUBE_MAP: return &state.textures[unit][1];
+            case GL_TEXTURE_2D_ARRAY: return &state.textures[unit][2];
+            case GL_TEXTURE_BUFFER: return &state.textures[unit][3];
+            default: return nullptr;
+        }
+    }
+
+    static void setCapability(GLenum cap, bool on) {
+        for (unsigned int i = 0; i < CAPABILITY_COUNT; i++) {
+            if (CAPABILITIES[i] != cap) continue;
+            if (track(state.capabilities[i] == (int)on)) return;
+            state.capabilities[i] = on;
+            break;
+        }
+        if (on) glEnable(cap);
+        else glDisable(cap);
+    }
+};
@@ -0,0 +1,16 @@
+#include "imageDecode.hpp"
+
+#include <stb/stb_image.h>
+
+DecodedImage decodeImage(const std::string& path, bool flip, int desiredChannels) {
+    DecodedImage image;
+
+    // Thread-local flip: concurrent decodes must not race on the global flag
+    stbi_set_flip_vertically_on_load_thread(flip);
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, desiredChannels);
+    if (!data) return image;
+
+    if (desiredChannels != 0) image.channels = desiredChannels;
+    image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+    return image;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// CPU-side decoded image. Safe to produce on any thread: the vertical flip
+// is passed per call instead of through stb_image's process-wide flag.
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::shared_ptr<unsigned char> pixels;
+
+    bool valid() const { return pixels != nullptr; }
+    size_t size() const { return (size_t)width * height * channels; }
+};
+
+DecodedImage decodeImage(const std::string& path, bool flip, int desiredChannels = 0);
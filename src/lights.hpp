@@ -3,100 +3,127 @@
 #include <glm/glm.hpp>
 #include <shader.hpp>
 
+#include "shaderVariants.hpp"
+
+// std140 mirrors of the structs in assets/shaders/lights.glsl. Every vec3 is
+// paired with a scalar so the C++ and GLSL layouts line up without padding rules.
 struct DirLight {
     glm::vec3 direction;
-	
+    float _pad0;
     glm::vec3 ambient;
+    float _pad1;
     glm::vec3 diffuse;
+    float _pad2;
     glm::vec3 specular;
+    float _pad3;
 };
 
 struct PointLight {
     glm::vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     glm::vec3 ambient;
+    float linear;
     glm::vec3 diffuse;
+    float quadratic;
     glm::vec3 specular;
+    float _pad0;
 };
 
 struct SpotLight {
     glm::vec3 position;
-    glm::vec3 direction;
     float cutOff;
+    glm::vec3 direction;
     float outerCutOff;
-  
+    glm::vec3 ambient;
     float constant;
+    glm::vec3 diffuse;
     float linear;
+    glm::vec3 specular;
     float quadratic;
-  
-    glm::vec3 ambient;
-    glm::vec3 diffuse;
-    glm::vec3 specular;       
 };
 
+#define MAX_POINT_LIGHTS 16
+
+// Point lights come last so a variant compiled for fewer lights reads a prefix
+struct LightData {
+    DirLight dirLight;
+    SpotLight spotLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+static_assert(sizeof(DirLight) == 64 && sizeof(PointLight) == 64 && sizeof(SpotLight) == 80,
+              "light structs must match the std140 layout");
+
 class Lights {
 public:
-    static void pointLight(int id, Shader& shader,glm::vec3 position, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic) {
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].position", position);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].ambient", ambient);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].diffuse", diffuse);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].specular", specular);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].constant", constant);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].linear", linear);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].quadratic", quadratic);
+    void pointLight(int id, glm::vec3 position, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic) {
+        if (id < 0 || id >= MAX_POINT_LIGHTS) return;
+        PointLight& light = data.pointLights[id];
+        light.position = position;
+        light.ambient = ambient;
+        light.diffuse = diffuse;
+        light.specular = specular;
+        light.constant = constant;
+        light.linear = linear;
+        light.quadratic = quadratic;
+        if ((unsigned int)id >= pointCount) pointCount = id + 1;
+    }
+
+    void pointLight(int id, glm::vec3 position, glm::vec3 color, float intensity, float radius) {
+        pointLight(id, position, color * intensity, (color * intensity) * 0.1f, glm::vec3(1.0f) * intensity,
+                   1.0f, 4.5f / radius, 75.0f / (radius * radius));
     }
 
-    static void pointLight(int id, Shader& shader, glm::vec3 position, glm::vec3 color, float intensity, float radius) {
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].position", position);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].ambient", color * intensity);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].diffuse", (color * intensity) * 0.1f);
-        shader.setVec3( "pointLights[" + std::to_string(id) + "].specular", glm::vec3(1.0f) * intensity);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].constant", 1.0f);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].linear", 4.5f / radius);
-        shader.setFloat("pointLights[" + std::to_string(id) + "].quadratic", 75.0f / (radius * radius));
+    void dirLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular) {
+        DirLight& light = data.dirLight;
+        light.direction = direction;
+        light.ambient = ambient;
+        light.diffuse = diffuse;
+        light.specular = specular;
+        hasDirLight = true;
     }
 
-    static void dirLight(Shader& shader, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular) {
-        shader.setVec3("dirLight.direction", direction);
-        shader.setVec3("dirLight.ambient", ambient);
-        shader.setVec3("dirLight.diffuse", diffuse);
-        shader.setVec3("dirLight.specular", specular);
+    void dirLight(glm::vec3 direction, glm::vec3 color, float intensity) {
+        dirLight(direction, (color * intensity) * 0.1f, color * intensity, glm::vec3(1.0f) * intensity);
     }
 
-    static void dirLight(Shader& shader, glm::vec3 direction, glm::vec3 color, float intensity) {
-        shader.setVec3("dirLight.direction", direction);
-        shader.setVec3("dirLight.ambient", (color * intensity) * 0.1f);
-        shader.setVec3("dirLight.diffuse", color * intensity);
-        shader.setVec3("dirLight.specular", glm::vec3(1.0f) * intensity);
+    void spotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff) {
+        SpotLight& light = data.spotLight;
+        light.position = position;
+        light.direction = direction;
+        light.ambient = ambient;
+        light.diffuse = diffuse;
+        light.specular = specular;
+        light.constant = constant;
+        light.linear = linear;
+        light.quadratic = quadratic;
+        light.cutOff = glm::cos(glm::radians(cutOff));
+        light.outerCutOff = glm::cos(glm::radians(outerCutOff));
+        hasSpotLight = true;
     }
 
-    static void spotLight(Shader& shader, glm::vec3 position, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff) {
-        shader.setVec3("spotLight.position", position);
-        shader.setVec3("spotLight.direction", direction);
-        shader.setVec3("spotLight.ambient", ambient);
-        shader.setVec3("spotLight.diffuse", diffuse);
-        shader.setVec3("spotLight.specular", specular);
-        shader.setFloat("spotLight.constant", constant);
-        shader.setFloat("spotLight.linear", linear);
-        shader.setFloat("spotLight.quadratic", quadratic);
-        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(cutOff)));
-        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(outerCutOff)));     
+    void spotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 color, float intensity, float radius, float cutOffDegrees, float outerCutOffDegrees) {
+        spotLight(position, direction, (color * intensity) * 1.0f, color * intensity, glm::vec3(1.0f) * intensity,
+                  1.0f, 4.5f / radius, 75.0f / (radius * radius), cutOffDegrees, outerCutOffDegrees);
     }
 
-    static void spotLight(Shader& shader, glm::vec3 position, glm::vec3 direction, glm::vec3 color, float intensity, float radius, float cutOffDegrees, float outerCutOffDegrees) {
-        shader.setVec3("spotLight.position", position);
-        shader.setVec3("spotLight.direction", direction);
-        shader.setVec3("spotLight.ambient", (color * intensity) * 1.0f);
-        shader.setVec3("spotLight.diffuse", color * intensity);
-        shader.setVec3("spotLight.specular", glm::vec3(1.0f) * intensity);
-        shader.setFloat("spotLight.constant", 1.0f);
-        shader.setFloat("spotLight.linear", 4.5f / radius);
-        shader.setFloat("spotLight.quadratic", 75.0f / (radius * radius));
-        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(cutOffDegrees)));
-        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(outerCutOffDegrees)));     
+    void disableDirLight() { hasDirLight = false; }
+    void disableSpotLight() { hasSpotLight = false; }
+    void clearPointLights() { pointCount = 0; }
+
+    // Lighting half of the variant key; objects add their material features
+    ShaderFeatures features() const {
+        ShaderFeatures f;
+        f.pointLights = pointCount;
+        f.dirLight = hasDirLight;
+        f.spotLight = hasSpotLight;
+        return f;
     }
-};
\ No newline at end of file
+
+    const LightData& Data() const { return data; }
+
+private:
+    LightData data{};
+    unsigned int pointCount = 0;
+    bool hasDirLight = false;
+    bool hasSpotLight = false;
+};
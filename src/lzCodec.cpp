@@ -0,0 +1,128 @@
+#include "lzCodec.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t LAST_LITERALS = 5;     // the block always ends in literals
+    const size_t MATCH_LIMIT = 12;      // no match may start this close to the end
+    const size_t MAX_OFFSET = 65535;
+    const int HASH_BITS = 14;
+
+    uint32_t read32(const unsigned char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t hash4(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void writeLength(std::vector<unsigned char>& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back((unsigned char)length);
+    }
+
+    void writeSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalLength,
+                       size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+        unsigned char token = (unsigned char)((literalLength < 15 ? literalLength : 15) << 4);
+        if (matchLength) token |= (unsigned char)(matchCode < 15 ? matchCode : 15);
+        out.push_back(token);
+        if (literalLength >= 15) writeLength(out, literalLength - 15);
+        out.insert(out.end(), literals, literals + literalLength);
+        if (!matchLength) return;
+
+        out.push_back((unsigned char)(offset & 0xFF));
+        out.push_back((unsigned char)(offset >> 8));
+        if (matchCode >= 15) writeLength(out, matchCode - 15);
+    }
+
+    bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& length) {
+        unsigned char byte;
+        do {
+            if (ip >= end) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+}
+
+std::vector<unsigned char> lzCompress(const unsigned char* src, size_t size) {
+    std::vector<unsigned char> out;
+    out.reserve(size / 2 + 16);
+
+    std::vector<uint32_t> table((size_t)1 << HASH_BITS, 0);   // position + 1, 0 = empty
+    size_t anchor = 0;
+    size_t ip = 0;
+    while (size >= MATCH_LIMIT && ip < size - MATCH_LIMIT) {
+        uint32_t sequence = read32(src + ip);
+        uint32_t& slot = table[hash4(sequence)];
+        size_t candidate = slot;
+        slot = (uint32_t)(ip + 1);
+
+        if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence) {
+            ip++;
+            continue;
+        }
+
+        size_t ref = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (ip + length < size - LAST_LITERALS && src[ref + length] == src[ip + length]) length++;
+
+        writeSequence(out, src + anchor, ip - anchor, ip - ref, length);
+        ip += length;
+        anchor = ip;
+    }
+
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize) {
+    const unsigned char* ip = src;
+    const unsigned char* end = src + srcSize;
+    size_t op = 0;
+
+    while (ip < end) {
+        unsigned char token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, literalLength)) return false;
+        if (literalLength > (size_t)(end - ip) || literalLength > dstSize - op) return false;
+        std::memcpy(dst + op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == end) break;   // the last sequence carries no match
+
+        if (end - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) return false;
+
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(ip, end, matchLength)) return false;
+        matchLength += MIN_MATCH;
+        if (matchLength > dstSize - op) return false;
+
+        // A match closer than its length repeats a pattern of `offset` bytes.
+        // Copying whole periods from its start never overlaps, and each copy
+        // doubles how much the next one may take.
+        unsigned char* out = dst + op;
+        const unsigned char* match = out - offset;
+        for (size_t copied = 0; copied < matchLength;) {
+            size_t n = matchLength - copied < offset + copied ? matchLength - copied : offset + copied;
+            std::memcpy(out + copied, match, n);
+            copied += n;
+        }
+        op += matchLength;
+    }
+    return op == dstSize;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Small LZ77 block codec using the LZ4 block layout: a token byte with
+// literal/match lengths, the literals, a 16-bit back offset. Greedy, one
+// hash probe per position; decodes at memcpy-like speed, which is what
+// cache files want. No framing: callers store the raw size themselves.
+std::vector<unsigned char> lzCompress(const unsigned char* src, size_t size);
+
+// Decodes exactly `dstSize` bytes into `dst` (which may be mapped GPU
+// memory). Returns false on malformed or truncated input.
+bool lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
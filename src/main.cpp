@@ -2,6 +2,8 @@
 #include <GLFW/glfw3.h>
 
 #include "shader.hpp"
+#include "programCache.hpp"
+#include "shaderLibrary.hpp"
 #include "texture.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -21,6 +23,7 @@
 
 #include "./objects/cube.hpp"
 #include "./objects/model.hpp"
+#include "./objects/crowd.hpp"
 #include "object.hpp"
 
 #include "framebuffer.hpp"
@@ -29,6 +32,7 @@
 #include <memory> 
 
 #include "renderer.hpp"
+#include "pipelineWarmup.hpp"
 
 #include <iostream>
 
@@ -52,8 +56,17 @@ glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
 bool cursorEnabled = false;
 
-int main()
+int main(int argc, char** argv)
 {
+    // --warmup: draw every pipeline once during loading, see PipelineWarmup
+    // --crowd <model>: add a crowd of an animated model, see Crowd
+    bool warmUp = false;
+    std::string crowdModel;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--warmup") warmUp = true;
+        if (std::string(argv[i]) == "--crowd" && i + 1 < argc) crowdModel = argv[++i];
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     Renderer Render(SCR_WIDTH, SCR_HEIGHT, "OpenGL Tutorial");
@@ -67,15 +80,29 @@ int main()
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);  
 
-    Shader shader("assets/shaders/shader.vs", "assets/shaders/shader.fs");
-    Shader screenShader("assets/shaders/screen_shader.vs", "assets/shaders/screen_shader.fs");
-    Shader lightCubeShader("assets/shaders/light_cube.vs", "assets/shaders/light_cube.fs");
-    Shader skyboxShader("assets/shaders/skybox.vs", "assets/shaders/skybox.fs");
-    Shader reflectShader("assets/shaders/reflect.vs", "assets/shaders/reflect.fs");
-
-    Texture tex("assets/textures/container2.png");
-    Texture spec("assets/textures/container2_specular.png");
-    Texture tex2("assets/textures/uv.png");
+    ShaderVariants litShader("assets/shaders/shader.vs", "assets/shaders/shader.fs");
+
+    ShaderLibrary shaders;
+    shaders.add("screen", "assets/shaders/screen_shader.vs", "assets/shaders/screen_shader.fs");
+    shaders.add("lightCube", "assets/shaders/light_cube.vs", "assets/shaders/light_cube.fs");
+    shaders.add("skybox", "assets/shaders/skybox.vs", "assets/shaders/skybox.fs");
+    shaders.add("reflect", "assets/shaders/reflect.vs", "assets/shaders/reflect.fs");
+    shaders.add("feedback", "assets/shaders/feedback.vs", "assets/shaders/feedback.fs");
+    shaders.compileAll();
+
+    Shader& screenShader = shaders.get("screen");
+    Shader& skyboxShader = shaders.get("skybox");
+    Shader& reflectShader = shaders.get("reflect");
+    Shader& feedbackShader = shaders.get("feedback");
+    UniformHandle<float> feedbackBias = feedbackShader.uniform<float>("feedbackBias");
+
+    // Diffuse maps are color: their mips are filtered in linear light
+    TextureOptions colorTexture;
+    colorTexture.color = true;
+    // The crate cubes sample array slices so they draw as one instanced batch
+    TextureLayerHandle crate = TextureArrays::load("assets/textures/container2.png", colorTexture);
+    TextureLayerHandle crateSpecular = TextureArrays::load("assets/textures/container2_specular.png");
+    Texture tex2 = Texture::loadAsync("assets/textures/uv.png", colorTexture);
 
     glm::vec3 cubePositions[] = {
         glm::vec3( 0.0f,  0.0f,  0.0f),
@@ -130,13 +157,22 @@ int main()
     Cubemap skybox(skyboxShader, faces, "skybox");
 
     Scene scene;
+    scene.SetLitShader(&litShader);
+
+    // directional light
+    scene.lights.dirLight(glm::vec3(-0.2f, -1.0f, -0.3f), glm::vec3(1.0f, 0.95f, 0.8f), 0.3f);
+    for (unsigned int i = 0; i < 4; i++) {
+        scene.lights.pointLight(i, pointLightPositions[i], glm::vec3(1.0f, 1.0f, 1.0f), 0.4f, 50.0f);
+    }
+    // flashlight, follows the camera every frame
+    scene.lights.spotLight(camera.Position, camera.Front, glm::vec3(1.0f,1.0f,1.0f), 0.8f, 20.0f, 12.5f, 15.0f);
     
     for (int i = 0; i < 10; i++) {
         auto cube = scene.NewInstance<Cube>();
         cube->position = cubePositions[i];
         cube->scale = glm::vec3(1.0f);
-        cube->diffuse = tex;
-        cube->specular = spec;
+        cube->diffuseLayer = crate;
+        cube->specularLayer = crateSpecular;
 
         scene.addObject("cube" + std::to_string(i), std::move(cube));
     }
@@ -154,6 +190,44 @@ int main()
     auto model = scene.NewInstance<Model>("assets/models/backpack/backpack.obj");
     
     scene.addObject("model", std::move(model));
+
+    // A 32 x 32 grid behind the cubes, cycling through the clips with staggered starts
+    if (!crowdModel.empty()) {
+        auto crowd = scene.NewInstance<Crowd>(crowdModel);
+        for (int i = 0; i < 1024; i++) {
+            glm::vec3 spot((i % 32) * 1.5f - 24.0f, -3.0f, -20.0f - (i / 32) * 1.5f);
+            crowd->add(glm::translate(glm::mat4(1.0f), spot), i % std::max<size_t>(crowd->clipCount(), 1), (i * 7 % 32) * 0.1f);
+        }
+        scene.addObject("crowd", std::move(crowd));
+    }
+
+    litShader.precompile(scene.LitFeatures());
+    ProgramCache::report();
+
+    if (warmUp) {
+        // Warm with the real texture formats rather than the placeholders
+        TextureLoader::finishAll();
+        TextureArrays::finishAll();
+
+        scene.view = camera.GetViewMatrix();
+        scene.projection = glm::perspective(glm::radians(camera.Zoom), (float)Render.SCR_W / (float)Render.SCR_H, 0.1f, 100.0f);
+        scene.cameraPos = camera.Position;
+
+        PipelineWarmup warmup;
+        warmup.draw(PipelineWarmup::SCENE_TARGET, [&]() {
+            GLState::enable(GL_DEPTH_TEST);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            scene.renderUniquePipelines();
+            skybox.Draw();
+        });
+        warmup.draw(PipelineWarmup::SCREEN_TARGET, [&]() {
+            GLState::disable(GL_DEPTH_TEST);
+            screenShader.use();
+            GLState::bindTexture(0, GL_TEXTURE_2D, buffer.Texture());
+            br.draw();
+        });
+        warmup.finish();
+    }
     
     
     // render loop
@@ -164,39 +238,81 @@ int main()
 
         scene.view = camera.GetViewMatrix();
         scene.projection = glm::perspective(glm::radians(camera.Zoom), (float)Render.SCR_W / (float)Render.SCR_H, 0.1f, 100.0f);
-
-        reflectShader.use();
-        reflectShader.setVec3("cameraPos", camera.Position);
+        scene.cameraPos = camera.Position;
+        scene.time = (float)glfwGetTime();
+        scene.deltaTime = dt;
+
+        // Low-res pass telling TextureStreamer which mips are visible
+        if (TextureStreamer::beginFeedback(Render.SCR_W, Render.SCR_H)) {
+            feedbackShader.use();
+            feedbackShader.set(feedbackBias, TextureStreamer::feedbackBias());
+            scene.renderFeedback(&feedbackShader);
+            TextureStreamer::endFeedback();
+        }
 
         buffer.BindFrameBuffer();
-        glEnable(GL_DEPTH_TEST);
+        GLState::enable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader.use();
-        // directional light
-        Lights::dirLight(shader, glm::vec3(-0.2f, -1.0f, -0.3f), glm::vec3(1.0f, 0.95f, 0.8f), 0.3f);
-        for (unsigned int i = 0; i < 4; i++) {
-            Lights::pointLight(i, shader, pointLightPositions[i], glm::vec3(1.0f, 1.0f, 1.0f), 0.4f, 50.0f);
-        }
         // spotLight
-        Lights::spotLight(shader, camera.Position, camera.Front, glm::vec3(1.0f,1.0f,1.0f), 0.8f, 20.0f, 12.5f, 15.0f); 
+        scene.lights.spotLight(camera.Position, camera.Front, glm::vec3(1.0f,1.0f,1.0f), 0.8f, 20.0f, 12.5f, 15.0f); 
 
         if (Object* obj = scene.getObject("model")) {
             obj->rotation = glm::vec3(0.0f, glfwGetTime() * 20, 0.0f);
         }
         ImGui::ShowDemoWindow();
 
+        ImGui::Begin("Stats");
+        ImGui::Text("Uniform lookups by name: %u", Shader::frameLookups());
+        ImGui::Text("Uniform uploads: %u", Shader::frameUploads());
+        ImGui::Text("GL state calls: %u issued, %u skipped", GLState::frameIssued(), GLState::frameSkipped());
+        ImGui::Text("Textures loading: %zu", TextureLoader::pending() + TextureArrays::pending());
+        ImGui::Text("Texture arrays: %zu", TextureArrays::arrayCount());
+        TextureCacheStats textureStats = TextureCache::stats();
+        ImGui::Text("Textures resident: %zu (%.1f MB), %u loads, %u hits", textureStats.resident,
+                    textureStats.bytes / (1024.0 * 1024.0), textureStats.loads, textureStats.hits);
+        TextureLoadStats loadStats = TextureLoader::GetStats();
+        ImGui::Text("  baked: %u (%.1f MB, %.1f ms)", loadStats.baked,
+                    loadStats.bakedBytes / (1024.0 * 1024.0), loadStats.bakedMilliseconds);
+        ImGui::Text("  decoded: %u (%.1f MB, %.1f ms)", loadStats.decoded,
+                    loadStats.decodedBytes / (1024.0 * 1024.0), loadStats.decodedMilliseconds);
+        TextureStreamStats streamStats = TextureStreamer::stats();
+        ImGui::Text("Streamed: %zu textures, %.1f / %.1f MB (wants %.1f), %u loads, %u evictions", streamStats.textures,
+                    streamStats.residentBytes / (1024.0 * 1024.0), streamStats.budget / (1024.0 * 1024.0),
+                    streamStats.wantedBytes / (1024.0 * 1024.0), streamStats.loads, streamStats.evictions);
+        int budgetMB = (int)(TextureStreamer::getBudget() >> 20);
+        if (ImGui::SliderInt("Stream budget (MB)", &budgetMB, 16, 1024)) {
+            TextureStreamer::setBudget((size_t)budgetMB << 20);
+        }
+        ImGui::Text("Process memory: %.1f MB resident, %.1f MB peak", currentResidentBytes() / (1024.0 * 1024.0),
+                    peakResidentBytes() / (1024.0 * 1024.0));
+        GeometryHeapStats geometryStats = GeometryHeap::stats();
+        ImGui::Text("Geometry heap: %zu meshes in %zu pools, %.1f / %.1f MB, %u grows, %u compactions",
+                    geometryStats.allocations, geometryStats.pools, geometryStats.usedBytes / (1024.0 * 1024.0),
+                    geometryStats.capacityBytes / (1024.0 * 1024.0), geometryStats.grows, geometryStats.compactions);
+        ImGui::Text("  drawn: %zu triangles in %u calls", GeometryHeap::frameTriangles(), GeometryHeap::frameDraws());
+        const MeshletCullStats& cullStats = MeshletCulling::lastFrame();
+        ImGui::Text("Meshlets: %zu, %zu outside the frustum, %zu back-facing", cullStats.meshlets,
+                    cullStats.frustumCulled, cullStats.backfaceCulled);
+        ImGui::Text("  triangles %zu -> %zu, vertices %zu -> %zu", cullStats.trianglesBefore, cullStats.trianglesAfter,
+                    cullStats.verticesBefore, cullStats.verticesAfter);
+        const AnimationStats& animStats = AnimationSystem::stats();
+        ImGui::Text("Animated: %zu instances, %zu bones, %.2f ms, %.1f KB palettes", animStats.instances,
+                    animStats.bones, animStats.updateMs, animStats.uploadBytes / 1024.0);
+        ImGui::Text("Lit shader variants: %zu", litShader.count());
+        ImGui::Text("Shader startup: %.2f ms (%u cached)", ProgramCache::GetStats().milliseconds, ProgramCache::GetStats().hits);
+        ImGui::End();
+
         scene.render();
 
-        skybox.Draw(scene.view, scene.projection, camera);
+        skybox.Draw();
 
         buffer.UnbindFrameBuffer();
-        glDisable(GL_DEPTH_TEST);
+        GLState::disable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT);
 
         screenShader.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, buffer.Texture());
+        GLState::bindTexture(0, GL_TEXTURE_2D, buffer.Texture());
         br.draw();
 
         Render.RenderLast();
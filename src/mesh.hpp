@@ -3,95 +3,275 @@
 #include <glm/glm.hpp>
 
 #include "texture.hpp"
-#include "bufferRenderer.hpp"
+#include "geometryHeap.hpp"
+#include "textureStreamer.hpp"
+#include "meshCache.hpp"
+#include "vertexFormat.hpp"
+#include "meshOptimizer.hpp"
+#include "meshBuilder.hpp"
 
 #include <stddef.h>
-
-
-#define MAX_BONE_INFLUENCE 4
-
-
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-	//bone indexes which will influence this vertex
-	int m_BoneIDs[MAX_BONE_INFLUENCE];
-	//weights from each bone
-	float m_Weights[MAX_BONE_INFLUENCE];
-};
+#include <cstring>
 
 
 struct Tex {
     unsigned int id;
     std::string type;
     std::string path;
+    TextureHandle handle;
+};
+
+#define LOD_SCREEN_ERROR 0.001f     // largest LOD error allowed on screen, as a fraction of its height
+#define LOD_HYSTERESIS 0.25f        // switch levels only this far past the threshold, so they do not flicker
+
+// What a Mesh keeps in CPU memory once its geometry is on the GPU
+enum class MeshResidency {
+    None,       // nothing: the GPU copy is the only one
+    Positions,  // positions + indices, for picking and physics
+    Full,       // vertices + indices as imported
 };
 
 class Mesh {
 public:
     std::vector<Vertex> vertices;
+    std::vector<glm::vec3> positions;   // only with MeshResidency::Positions
     std::vector<unsigned int> indices;
     std::vector<Tex> textures;
+    std::vector<MeshLod> lods;          // at least one: the full mesh
+    std::vector<Meshlet> meshlets;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    bool skinned = false;               // carries bone weights
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Tex> textures)
-        : vertices(vertices), indices(indices), textures(textures) {
-        setupMesh();
+    // Uploads a mesh built by prepareMesh; the CPU copies `residency` asks for are taken from it
+    Mesh(PreparedMesh& prepared, std::vector<Tex> textures, MeshResidency residency)
+        : textures(std::move(textures)), lods(prepared.lods), meshlets(prepared.meshlets), boundsMin(prepared.boundsMin), boundsMax(prepared.boundsMax),
+          skinned(prepared.skinned) {
+        uploadPrepared(prepared);
+        if (residency == MeshResidency::Full) vertices = std::move(prepared.vertices);
+        if (residency == MeshResidency::Positions) {
+            positions.reserve(prepared.vertices.size());
+            for (auto& v : prepared.vertices) positions.push_back(v.Position);
+        }
+        // the full-detail level only
+        if (residency != MeshResidency::None) indices.assign(prepared.indices.begin(), prepared.indices.begin() + lods[0].indexCount);
+        setupSamplerNames();
+        setupFeedbackSlot();
     };
+    // Uploads from a mesh cache mapping; CPU copies are only decoded when `residency` asks for them
+    Mesh(const MeshCache::Entry& cached, std::vector<Tex> textures, MeshResidency residency)
+        : textures(std::move(textures)), lods(cached.lods), meshlets(cached.meshlets), boundsMin(cached.boundsMin), boundsMax(cached.boundsMax),
+          skinned(cached.skinned) {
+        if (lods.empty()) {
+            lods.assign(1, MeshLod());
+            lods[0].indexCount = cached.indexCount;
+        }
+        uploaded = uploadCached(cached, residency != MeshResidency::None);
+        if (indices.size() > lods[0].indexCount) indices.resize(lods[0].indexCount);
+        ApplyResidency(residency);
+        setupSamplerNames();
+        setupFeedbackSlot();
+    };
+    // Frees what `residency` does not keep (swap, so the capacity goes too)
+    void ApplyResidency(MeshResidency residency) {
+        if (residency == MeshResidency::Full) return;
+        if (residency == MeshResidency::Positions && positions.empty()) {
+            positions.reserve(vertices.size());
+            for (auto& v : vertices) positions.push_back(v.Position);
+        }
+        std::vector<Vertex>().swap(vertices);
+        if (residency == MeshResidency::None) {
+            std::vector<glm::vec3>().swap(positions);
+            std::vector<unsigned int>().swap(indices);
+        }
+    }
+    size_t CpuBytes() const {
+        return vertices.capacity() * sizeof(Vertex) + positions.capacity() * sizeof(glm::vec3) +
+               indices.capacity() * sizeof(unsigned int);
+    }
     void Draw(Shader &shader) {
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
+        BindMaterial(shader);
+        GeometryHeap::draw(geometry, DrawRange());
+    };
+    // `errorScale` is the fraction of the screen height one object-space unit
+    // covers at the mesh's distance. Picks the coarsest level whose error
+    // stays under LOD_SCREEN_ERROR, moving only once past the hysteresis band.
+    void SelectLod(float errorScale) {
+        auto projected = [&](size_t level) { return lods[level].error * errorScale; };
+        while (lodLevel + 1 < lods.size() && projected(lodLevel + 1) <= LOD_SCREEN_ERROR * (1.0f - LOD_HYSTERESIS)) lodLevel++;
+        while (lodLevel > 0 && projected(lodLevel) > LOD_SCREEN_ERROR * (1.0f + LOD_HYSTERESIS)) lodLevel--;
+    }
+    size_t LodLevel() const { return lodLevel; }
+    IndexRange DrawRange() const { return IndexRange{lods[lodLevel].firstIndex, lods[lodLevel].indexCount}; }
+    // Keeps the current level's meshlets that survive `view`; neighbours in
+    // the index list merge, so each unbroken run is one range of the multi-draw
+    void CullMeshlets(const MeshletView& view, MeshletCullStats& stats) {
+        culled = true;
+        visibleRanges.clear();
+        const MeshLod& lod = lods[lodLevel];
+        if (!lod.meshletCount) {
+            visibleRanges.push_back(DrawRange());
+            return;
+        }
+        for (uint32_t i = lod.firstMeshlet; i < lod.firstMeshlet + lod.meshletCount; i++) {
+            const Meshlet& m = meshlets[i];
+            stats.meshlets++;
+            stats.trianglesBefore += m.indexCount / 3;
+            stats.verticesBefore += m.vertexCount;
+
+            MeshletCull result = cullMeshlet(m, view);
+            if (result == MeshletCull::Frustum) stats.frustumCulled++;
+            if (result == MeshletCull::Backface) stats.backfaceCulled++;
+            if (result != MeshletCull::Visible) continue;
+
+            stats.trianglesAfter += m.indexCount / 3;
+            stats.verticesAfter += m.vertexCount;
+            if (!visibleRanges.empty() && visibleRanges.back().first + visibleRanges.back().count == m.firstIndex) {
+                visibleRanges.back().count += m.indexCount;
+            } else {
+                visibleRanges.push_back(IndexRange{m.firstIndex, m.indexCount});
+            }
+        }
+    }
+    // Everything at the current level until the first CullMeshlets
+    const std::vector<IndexRange>& VisibleRanges() {
+        if (!culled) visibleRanges.assign(1, DrawRange());
+        return visibleRanges;
+    }
+    void BindMaterial(Shader &shader) {
+        if (samplerProgram != shader.ID) resolveSamplers(shader);
+
         for (unsigned int i = 0; i < textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i);
+            shader.set(samplers[i], (int)i);
+            GLState::bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+        }
+        shader.set(feedbackUniform, feedbackSlot);   // only the feedback shader has it
+    }
+    // Same pool and same textures: one BindMaterial and one multi-draw covers both
+    bool BatchesWith(const Mesh& other) const {
+        return GeometryHeap::pool(geometry) == GeometryHeap::pool(other.geometry) && SameMaterial(other);
+    }
+    bool SameMaterial(const Mesh& other) const {
+        if (textures.size() != other.textures.size()) return false;
+        for (size_t i = 0; i < textures.size(); i++) {
+            if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type) return false;
+        }
+        return true;
+    }
+    // Meshes are not owned RAII-style (they are copied around freely); the
+    // loader gives their heap ranges back
+    void Release() {
+        GeometryHeap::release(geometry);
+        geometry = 0;
+    }
+    uint64_t LayoutKey() const { return GeometryHeap::layoutKey(geometry); }
+    GeometryHandle Geometry() const { return geometry; }
+    bool Uploaded() const { return uploaded; }
+    VertexFormat Format() const { return format; }
+private:
+    GeometryHandle geometry = 0;
+    VertexFormat format = VertexFormat::Full;
+    size_t lodLevel = 0;
+    bool culled = false;
+    std::vector<IndexRange> visibleRanges;
+    bool uploaded = true;
+
+    // "material.texture_diffuse1", ... built once, resolved per program
+    std::vector<std::string> samplerNames;
+    std::vector<UniformHandle<int>> samplers;
+    unsigned int samplerProgram = 0;
+
+    // All of a mesh's textures share its UVs, so one streaming feedback slot covers them
+    int feedbackSlot = 0;
+    UniformHandle<int> feedbackUniform;
 
+    void setupSamplerNames() {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        for (auto& tex : textures) {
             std::string number;
-            std::string name = textures[i].type;
-            if (name == "texture_diffuse") {
+            if (tex.type == "texture_diffuse") {
                 number = std::to_string(diffuseNr++);
             } else {
                 number = std::to_string(specularNr++);
             }
+            samplerNames.push_back("material." + tex.type + number);
+        }
+    }
 
-            shader.setInt(("material." + name + number).c_str(), i);
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    void resolveSamplers(const Shader& shader) {
+        samplerProgram = shader.ID;
+        samplers.clear();
+        for (auto& name : samplerNames) {
+            samplers.push_back(shader.uniform<int>(name));
         }
-        glActiveTexture(GL_TEXTURE0);
+        feedbackUniform = shader.uniform<int>("feedbackSlot");
+    }
 
-        buf.draw();
-    };
-private:
-    BufferRenderer buf;
+    void setupFeedbackSlot() {
+        std::vector<GLuint> ids;
+        for (auto& tex : textures) ids.push_back(tex.id);
+        feedbackSlot = TextureStreamer::slotFor(ids);
+    }
+
+    // Raw blocks go to the driver straight from the file mapping; compressed
+    // ones are decoded into the mapped range, so nothing is staged in between.
+    // With `keepCpu` the blocks are decoded once to memory and uploaded from there.
+    bool uploadCached(const MeshCache::Entry& cached, bool keepCpu) {
+        format = (VertexFormat)cached.vertexFormat;
+        if (cached.vertexStride != vertexStride(format)) return false;
 
-    void setupMesh() {
-        // Upload vertex + index buffers
-        buf.setVertices(vertices);
-        buf.setIndices(indices);
+        geometry = GeometryHeap::allocate(format, cached.vertexCount, cached.indexCount, cached.indexSize);
+        if (!geometry) return false;
 
-        // Struct stride
-        buf.setStride(sizeof(Vertex));
+        if (keepCpu) {
+            std::vector<unsigned char> stream(cached.vertices.size);
+            std::vector<unsigned char> indexStream(cached.indices.size);
+            if (!MeshCache::read(cached.vertices, stream.data()) || !MeshCache::read(cached.indices, indexStream.data())) {
+                return false;
+            }
+            GeometryHeap::writeVertices(geometry, stream.data());
+            GeometryHeap::writeIndices(geometry, indexStream.data());
 
-        // ---- Vertex Attributes ----
-        buf.addAttribOffset(0, 3, GL_FLOAT,  offsetof(Vertex, Position));     // vec3
-        buf.addAttribOffset(1, 3, GL_FLOAT,  offsetof(Vertex, Normal));       // vec3
-        buf.addAttribOffset(2, 2, GL_FLOAT,  offsetof(Vertex, TexCoords));    // vec2
-        buf.addAttribOffset(3, 3, GL_FLOAT,  offsetof(Vertex, Tangent));      // vec3
-        buf.addAttribOffset(4, 3, GL_FLOAT,  offsetof(Vertex, Bitangent));    // vec3
+            vertices = unpackVertices(stream.data(), cached.vertexCount, format);
+            indices.resize(cached.indexCount);
+            for (size_t i = 0; i < indices.size(); i++) {
+                if (cached.indexSize == 2) {
+                    unsigned short index;
+                    std::memcpy(&index, indexStream.data() + i * 2, 2);
+                    indices[i] = index;
+                } else {
+                    std::memcpy(&indices[i], indexStream.data() + i * 4, 4);
+                }
+            }
+            return true;
+        }
 
-        // bone IDs → int[4] → use GL_INT
-        buf.addAttribOffset(5, 4, GL_INT,    offsetof(Vertex, m_BoneIDs));    // ivec4
+        bool ok = true;
+        if (!cached.vertices.compressed()) {
+            GeometryHeap::writeVertices(geometry, cached.vertices.data);
+        } else {
+            void* mapped = GeometryHeap::mapVertices(geometry);
+            ok = mapped && MeshCache::read(cached.vertices, mapped);
+            if (mapped) ok = GeometryHeap::unmapVertices(geometry) && ok;
+        }
 
-        // weights → float[4]
-        buf.addAttribOffset(6, 4, GL_FLOAT,  offsetof(Vertex, m_Weights));    // vec4
+        if (!cached.indices.compressed()) {
+            GeometryHeap::writeIndices(geometry, cached.indices.data);
+        } else {
+            void* mapped = GeometryHeap::mapIndices(geometry);
+            ok = mapped && MeshCache::read(cached.indices, mapped) && ok;
+            if (mapped) ok = GeometryHeap::unmapIndices(geometry) && ok;
+        }
+        return ok;
+    }
 
-        // Build VAO
-        buf.link();
+    void uploadPrepared(const PreparedMesh& prepared) {
+        // Sub-allocate from the shared heap in the layout prepareMesh chose
+        format = prepared.format;
+        geometry = GeometryHeap::allocate(format, prepared.vertices.size(), prepared.indices.size(), prepared.indexSize());
+        GeometryHeap::writeVertices(geometry, prepared.stream.data());
+        GeometryHeap::writeIndices(geometry, prepared.indexData());
     }
 
 };
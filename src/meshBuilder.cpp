@@ -0,0 +1,77 @@
+#include "meshBuilder.hpp"
+
+#include <cmath>
+
+void generateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    std::vector<glm::vec3> tangents(vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3(0.0f));
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        const Vertex& v0 = vertices[a];
+        glm::vec3 e1 = vertices[b].Position - v0.Position;
+        glm::vec3 e2 = vertices[c].Position - v0.Position;
+        glm::vec2 d1 = vertices[b].TexCoords - v0.TexCoords;
+        glm::vec2 d2 = vertices[c].TexCoords - v0.TexCoords;
+
+        float det = d1.x * d2.y - d2.x * d1.y;
+        if (std::fabs(det) < 1e-12f) continue;
+        float r = 1.0f / det;
+        // area-weighted: the unnormalized face vectors scale with the triangle
+        glm::vec3 t = (e1 * d2.y - e2 * d1.y) * r;
+        glm::vec3 bt = (e2 * d1.x - e1 * d2.x) * r;
+        for (unsigned int k : {a, b, c}) {
+            tangents[k] += t;
+            bitangents[k] += bt;
+        }
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        Vertex& v = vertices[i];
+        glm::vec3 t = tangents[i] - v.Normal * glm::dot(v.Normal, tangents[i]);   // Gram-Schmidt
+        float length = glm::length(t);
+        if (length < 1e-8f) continue;
+        t /= length;
+        float handedness = glm::dot(glm::cross(v.Normal, t), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+        v.Tangent = t;
+        v.Bitangent = glm::cross(v.Normal, t) * handedness;
+    }
+}
+
+PreparedMesh prepareMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+                         bool triangles, bool needsTangents) {
+    PreparedMesh out;
+    out.vertices = std::move(vertices);
+    out.indices = std::move(indices);
+
+    // weld, reorder for the vertex cache and overdraw, then for fetch locality;
+    // tangents come after, so welding sees the source attributes only
+    if (triangles) out.stats = optimizeMesh(out.vertices, out.indices);
+    if (triangles && needsTangents) generateTangents(out.vertices, out.indices);
+    if (triangles) {
+        out.lods = buildLodChain(out.vertices, out.indices);
+        for (auto& lod : out.lods) {
+            lod.firstMeshlet = (uint32_t)out.meshlets.size();
+            buildMeshlets(out.vertices, out.indices, lod.firstIndex, lod.indexCount, out.meshlets);
+            lod.meshletCount = (uint32_t)out.meshlets.size() - lod.firstMeshlet;
+        }
+    } else {
+        MeshLod whole;
+        whole.indexCount = (uint32_t)out.indices.size();
+        out.lods.assign(1, whole);
+    }
+
+    if (!out.vertices.empty()) {
+        out.boundsMin = out.boundsMax = out.vertices[0].Position;
+        for (auto& v : out.vertices) {
+            out.boundsMin = glm::min(out.boundsMin, v.Position);
+            out.boundsMax = glm::max(out.boundsMax, v.Position);
+        }
+    }
+
+    out.format = chooseVertexFormat(out.vertices);
+    out.stream = packVertices(out.vertices, out.format);
+    out.shortIndex = fitsShortIndices(out.vertices.size());
+    if (out.shortIndex) out.shortIndices = narrowIndices(out.indices);
+    return out;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "vertexFormat.hpp"
+#include "meshOptimizer.hpp"
+#include "meshSimplify.hpp"
+#include "meshlet.hpp"
+
+#include <vector>
+
+// Everything a Mesh needs before it touches GL: optimized arrays, the GPU
+// vertex stream in its final layout and the narrowed index list. Built on
+// the thread pool by prepareMesh; Mesh only uploads it.
+struct PreparedMesh {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;          // every LOD level, back to back
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;              // per level, see MeshLod
+    VertexFormat format = VertexFormat::Full;
+    std::vector<unsigned char> stream;          // vertices packed as `format`
+    std::vector<unsigned short> shortIndices;   // only when shortIndex is set
+    bool shortIndex = false;
+    bool skinned = false;                       // bone weights were imported
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    MeshOptimizeStats stats;
+
+    size_t indexSize() const { return shortIndex ? 2 : 4; }
+    const void* indexData() const {
+        return shortIndex ? (const void*)shortIndices.data() : (const void*)indices.data();
+    }
+};
+
+// Per-vertex tangent frames from UV gradients (Lengyel), orthogonalized
+// against the normal. Degenerate UVs leave a vertex's tangent zero.
+void generateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+// The CPU half of a mesh upload: optimize (triangle lists only), generate
+// tangents when the source had none, build the LOD chain and its meshlets,
+// then pack.
+// GL-free, so it runs on pool workers.
+PreparedMesh prepareMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+                         bool triangles, bool needsTangents);
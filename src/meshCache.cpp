@@ -0,0 +1,396 @@
+#include "meshCache.hpp"
+#include "lzCodec.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+    const uint32_t CACHE_MAGIC = 0x48534D47; // "GMSH"
+    const size_t BLOCK_ALIGN = 16;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t meshCount;
+        uint32_t reserved;
+        uint64_t key;
+        uint64_t animationOffset;   // 0 for static models
+        uint64_t animationSize;
+    };
+
+    // Writers run in the background, possibly several for the same cache
+    // at once (two cold loads of one model); each gets its own temporary
+    std::string tempPath(const std::string& path) {
+        static const unsigned int process = std::random_device()();
+        static std::atomic<unsigned int> next{0};
+        return path + "." + std::to_string(process) + "." + std::to_string(next++) + ".tmp";
+    }
+
+    static_assert(sizeof(MeshLod) == 20 && sizeof(Meshlet) == 44, "LOD and meshlet records are stored as-is");
+    static_assert(sizeof(PackedKey) == 10 && sizeof(TrackRange) == 24 && sizeof(JointPose) == 48 && sizeof(JointMatrix) == 64,
+                  "animation records are stored as-is");
+
+    struct MeshEntry {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t textureCount;
+        uint32_t vertexFormat;
+        uint32_t vertexStride;
+        uint32_t indexSize;
+        uint64_t vertexOffset;
+        uint64_t vertexStored;
+        uint64_t indexOffset;
+        uint64_t indexStored;
+        uint64_t textureOffset;     // textureCount x (u16 type length, u16 path length, type, path)
+        uint32_t lodCount;
+        uint32_t meshletCount;
+        uint64_t lodOffset;         // lodCount x MeshLod
+        uint64_t meshletOffset;     // meshletCount x Meshlet
+        float boundsMin[3];
+        float boundsMax[3];
+        uint32_t skinned;
+        uint32_t reserved;
+    };
+
+    uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+        for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    void pad(std::vector<unsigned char>& out) {
+        while (out.size() % BLOCK_ALIGN) out.push_back(0);
+    }
+
+    template<typename T>
+    void append(std::vector<unsigned char>& out, const T& value) {
+        const unsigned char* bytes = (const unsigned char*)&value;
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Keeps the compressed form only when it is actually smaller
+    void appendBlock(std::vector<unsigned char>& out, const void* data, size_t size, bool compress,
+                     uint64_t& offset, uint64_t& stored) {
+        pad(out);
+        offset = out.size();
+        const unsigned char* bytes = (const unsigned char*)data;
+        if (compress && size > 0) {
+            std::vector<unsigned char> packed = lzCompress(bytes, size);
+            if (packed.size() < size) {
+                out.insert(out.end(), packed.begin(), packed.end());
+                stored = packed.size();
+                return;
+            }
+        }
+        out.insert(out.end(), bytes, bytes + size);
+        stored = size;
+    }
+
+    void appendString(std::vector<unsigned char>& out, const std::string& text) {
+        uint16_t length = (uint16_t)std::min<size_t>(text.size(), 0xFFFF);
+        append(out, length);
+        out.insert(out.end(), text.begin(), text.begin() + length);
+    }
+
+    template<typename T>
+    void appendArray(std::vector<unsigned char>& out, const std::vector<T>& values) {
+        append(out, (uint32_t)values.size());
+        const unsigned char* bytes = (const unsigned char*)values.data();
+        out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    // Joints (name, parent, bone, bind pose), bone offsets and the root
+    // inverse, then per clip its name, duration, track joints, ranges and key
+    // streams; records are written as they are in memory, like LODs and meshlets
+    void appendAnimation(std::vector<unsigned char>& out, const MeshCacheAnimation& animation) {
+        const Skeleton& skeleton = *animation.skeleton;
+        append(out, (uint32_t)skeleton.joints.size());
+        for (auto& joint : skeleton.joints) {
+            appendString(out, joint.name);
+            append(out, (int32_t)joint.parent);
+            append(out, (int32_t)joint.bone);
+            append(out, joint.bind);
+        }
+        appendArray(out, skeleton.boneOffsets);
+        append(out, skeleton.globalInverse);
+
+        append(out, (uint32_t)animation.clips.size());
+        for (auto& clip : animation.clips) {
+            appendString(out, clip->name);
+            append(out, clip->duration);
+            appendArray(out, clip->joints);
+            for (int c = 0; c < ANIMATION_CHANNELS; c++) {
+                appendArray(out, clip->ranges[c]);
+                appendArray(out, clip->keys[c]);
+            }
+        }
+    }
+
+    // Bounds-checked cursor over the animation section; any overrun sticks in `ok`
+    struct Reader {
+        const unsigned char* data;
+        size_t size;
+        size_t at = 0;
+        bool ok = true;
+
+        template<typename T>
+        T get() {
+            T value{};
+            if (!ok || size - at < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, data + at, sizeof(T));
+            at += sizeof(T);
+            return value;
+        }
+
+        std::string string() {
+            uint16_t length = get<uint16_t>();
+            if (!ok || size - at < length) {
+                ok = false;
+                return std::string();
+            }
+            std::string text((const char*)data + at, length);
+            at += length;
+            return text;
+        }
+
+        template<typename T>
+        void array(std::vector<T>& out) {
+            uint32_t count = get<uint32_t>();
+            if (!ok || (size - at) / sizeof(T) < count) {
+                ok = false;
+                return;
+            }
+            out.resize(count);
+            if (count) std::memcpy((void*)out.data(), data + at, count * sizeof(T));
+            at += count * sizeof(T);
+        }
+    };
+
+    bool readAnimation(const unsigned char* data, size_t size, MeshCacheAnimation& animation) {
+        Reader in{data, size};
+        auto skeleton = std::make_shared<Skeleton>();
+        uint32_t jointCount = in.get<uint32_t>();
+        if (!in.ok || jointCount > size) return false;
+        skeleton->joints.resize(jointCount);
+        for (uint32_t j = 0; j < jointCount && in.ok; j++) {
+            Joint& joint = skeleton->joints[j];
+            joint.name = in.string();
+            joint.parent = in.get<int32_t>();
+            joint.bone = in.get<int32_t>();
+            joint.bind = in.get<JointPose>();
+            if (joint.parent >= (int)j || joint.parent < -1) return false;
+        }
+        in.array(skeleton->boneOffsets);
+        skeleton->globalInverse = in.get<JointMatrix>();
+        if (!in.ok || skeleton->boneCount() > MAX_BONES) return false;
+        for (auto& joint : skeleton->joints) {
+            if (joint.bone < -1 || joint.bone >= (int)skeleton->boneCount()) return false;
+        }
+
+        uint32_t clipCount = in.get<uint32_t>();
+        if (!in.ok || clipCount > size) return false;
+        std::vector<std::shared_ptr<const CompressedClip>> clips;
+        for (uint32_t c = 0; c < clipCount; c++) {
+            auto clip = std::make_shared<CompressedClip>();
+            clip->name = in.string();
+            clip->duration = in.get<float>();
+            in.array(clip->joints);
+            for (int channel = 0; channel < ANIMATION_CHANNELS; channel++) {
+                in.array(clip->ranges[channel]);
+                in.array(clip->keys[channel]);
+            }
+            if (!in.ok) return false;
+            for (uint16_t joint : clip->joints) {
+                if (joint >= jointCount) return false;
+            }
+            for (int channel = 0; channel < ANIMATION_CHANNELS; channel++) {
+                if (clip->ranges[channel].size() != clip->trackCount()) return false;
+                for (auto& key : clip->keys[channel]) {
+                    if ((key.track & 0x3FFF) >= clip->trackCount()) return false;
+                }
+            }
+            clips.push_back(std::move(clip));
+        }
+        animation.skeleton = std::move(skeleton);
+        animation.clips = std::move(clips);
+        return true;
+    }
+}
+
+uint64_t meshCacheKey(const std::string& source, uint32_t importFlags, uint32_t vertexSize) {
+    MappedFile file;
+    if (!file.open(source)) return 0;
+
+    uint64_t hash = fnv1a(file.data(), file.size());
+    uint32_t salt[3] = {MESH_CACHE_VERSION, importFlags, vertexSize};
+    hash = fnv1a((const unsigned char*)salt, sizeof(salt), hash);
+    return hash ? hash : 1;
+}
+
+bool writeMeshCache(const std::string& path, uint64_t key, const std::vector<MeshCacheInput>& meshes,
+                    const MeshCacheAnimation& animation, bool compress) {
+    std::vector<unsigned char> out;
+    CacheHeader header{CACHE_MAGIC, MESH_CACHE_VERSION, (uint32_t)meshes.size(), 0, key, 0, 0};
+    append(out, header);
+
+    // Table first (patched below), then texture references, then data blocks
+    size_t tableOffset = out.size();
+    std::vector<MeshEntry> entries(meshes.size());
+    out.resize(out.size() + entries.size() * sizeof(MeshEntry));
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshCacheInput& mesh = meshes[i];
+        MeshEntry& entry = entries[i];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.vertexCount = mesh.vertexCount;
+        entry.indexCount = mesh.indexCount;
+        entry.textureCount = (uint32_t)mesh.textures.size();
+        entry.vertexFormat = mesh.vertexFormat;
+        entry.vertexStride = mesh.vertexStride;
+        entry.indexSize = mesh.indexSize;
+        entry.skinned = mesh.skinned;
+        for (int c = 0; c < 3; c++) {
+            entry.boundsMin[c] = mesh.boundsMin[c];
+            entry.boundsMax[c] = mesh.boundsMax[c];
+        }
+
+        entry.textureOffset = out.size();
+        for (auto& texture : mesh.textures) {
+            append(out, (uint16_t)texture.type.size());
+            append(out, (uint16_t)texture.path.size());
+            out.insert(out.end(), texture.type.begin(), texture.type.end());
+            out.insert(out.end(), texture.path.begin(), texture.path.end());
+        }
+
+        entry.lodCount = (uint32_t)mesh.lods.size();
+        entry.lodOffset = out.size();
+        for (auto& lod : mesh.lods) append(out, lod);
+        entry.meshletCount = (uint32_t)mesh.meshlets.size();
+        entry.meshletOffset = out.size();
+        for (auto& meshlet : mesh.meshlets) append(out, meshlet);
+    }
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshCacheInput& mesh = meshes[i];
+        appendBlock(out, mesh.vertices, (size_t)mesh.vertexCount * mesh.vertexStride, compress,
+                    entries[i].vertexOffset, entries[i].vertexStored);
+        appendBlock(out, mesh.indices, (size_t)mesh.indexCount * mesh.indexSize, compress,
+                    entries[i].indexOffset, entries[i].indexStored);
+    }
+    if (!entries.empty()) std::memcpy(out.data() + tableOffset, entries.data(), entries.size() * sizeof(MeshEntry));
+    if (animation.skeleton) {
+        pad(out);
+        header.animationOffset = out.size();
+        appendAnimation(out, animation);
+        header.animationSize = out.size() - header.animationOffset;
+        std::memcpy(out.data(), &header, sizeof(header));
+    }
+
+    // Write to a temporary name first so a crash never leaves a torn file
+    // and rename it over the cache; the last of concurrent writers wins with the same contents
+    std::error_code ec;
+    std::string temp = tempPath(path);
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write((const char*)out.data(), (std::streamsize)out.size());
+    file.close();
+    if (!file) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(temp, ignored);
+    }
+    return !ec;
+}
+
+bool MeshCache::open(const std::string& path, uint64_t key) {
+    table.clear();
+    anim = MeshCacheAnimation();
+    if (!file.open(path)) return false;
+
+    const unsigned char* base = file.data();
+    size_t size = file.size();
+    if (size < sizeof(CacheHeader)) return false;
+
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != MESH_CACHE_VERSION) return false;
+    if (header.key != key) return false;
+    if (header.meshCount > (size - sizeof(CacheHeader)) / sizeof(MeshEntry)) return false;
+
+    auto inside = [size](uint64_t offset, uint64_t length) { return offset <= size && length <= size - offset; };
+
+    std::vector<Entry> meshes(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        MeshEntry entry;
+        std::memcpy(&entry, base + sizeof(CacheHeader) + i * sizeof(MeshEntry), sizeof(entry));
+        if (!inside(entry.vertexOffset, entry.vertexStored) || !inside(entry.indexOffset, entry.indexStored)) return false;
+
+        Entry& mesh = meshes[i];
+        mesh.vertexCount = entry.vertexCount;
+        mesh.indexCount = entry.indexCount;
+        mesh.vertexFormat = entry.vertexFormat;
+        mesh.vertexStride = entry.vertexStride;
+        mesh.indexSize = entry.indexSize;
+        mesh.skinned = entry.skinned != 0;
+        if (entry.indexSize != 2 && entry.indexSize != 4) return false;
+        mesh.vertices = {base + entry.vertexOffset, (size_t)entry.vertexStored, (size_t)entry.vertexCount * entry.vertexStride};
+        mesh.indices = {base + entry.indexOffset, (size_t)entry.indexStored, (size_t)entry.indexCount * entry.indexSize};
+        mesh.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+        mesh.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+        if (mesh.vertices.stored > mesh.vertices.size || mesh.indices.stored > mesh.indices.size) return false;
+
+        uint64_t offset = entry.textureOffset;
+        for (uint32_t t = 0; t < entry.textureCount; t++) {
+            if (!inside(offset, 4)) return false;
+            uint16_t lengths[2];
+            std::memcpy(lengths, base + offset, sizeof(lengths));
+            offset += sizeof(lengths);
+            if (!inside(offset, (uint64_t)lengths[0] + lengths[1])) return false;
+
+            CachedTexture texture;
+            texture.type.assign((const char*)base + offset, lengths[0]);
+            texture.path.assign((const char*)base + offset + lengths[0], lengths[1]);
+            offset += lengths[0] + lengths[1];
+            mesh.textures.push_back(std::move(texture));
+        }
+
+        if (!inside(entry.lodOffset, (uint64_t)entry.lodCount * sizeof(MeshLod))) return false;
+        if (!inside(entry.meshletOffset, (uint64_t)entry.meshletCount * sizeof(Meshlet))) return false;
+        mesh.lods.resize(entry.lodCount);
+        if (entry.lodCount) std::memcpy(mesh.lods.data(), base + entry.lodOffset, entry.lodCount * sizeof(MeshLod));
+        mesh.meshlets.resize(entry.meshletCount);
+        if (entry.meshletCount) std::memcpy(mesh.meshlets.data(), base + entry.meshletOffset, entry.meshletCount * sizeof(Meshlet));
+        for (auto& lod : mesh.lods) {
+            if ((uint64_t)lod.firstIndex + lod.indexCount > entry.indexCount) return false;
+            if ((uint64_t)lod.firstMeshlet + lod.meshletCount > entry.meshletCount) return false;
+        }
+        for (auto& meshlet : mesh.meshlets) {
+            if ((uint64_t)meshlet.firstIndex + meshlet.indexCount > entry.indexCount) return false;
+        }
+    }
+
+    if (header.animationOffset) {
+        if (!inside(header.animationOffset, header.animationSize)) return false;
+        if (!readAnimation(base + header.animationOffset, (size_t)header.animationSize, anim)) return false;
+    }
+
+    table = std::move(meshes);
+    return true;
+}
+
+bool MeshCache::read(const Block& block, void* dst) {
+    if (!block.compressed()) {
+        std::memcpy(dst, block.data, block.size);
+        return true;
+    }
+    return lzDecompress(block.data, block.stored, (unsigned char*)dst, block.size);
+}
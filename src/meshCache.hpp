@@ -0,0 +1,100 @@
+#pragma once
+
+#include "mappedFile.hpp"
+#include "meshSimplify.hpp"
+#include "meshlet.hpp"
+#include "animation.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define MESH_CACHE_VERSION 8
+#define MESH_CACHE_COMPRESSED 1     // LZ-compress vertex and index blocks on write
+
+// Processed models are cached next to their source: "foo.obj" -> "foo.obj.gmesh"
+inline std::string meshCachePath(const std::string& source) { return source + ".gmesh"; }
+
+// Content hash of the source plus everything that changes the processed
+// result; 0 when the source cannot be read
+uint64_t meshCacheKey(const std::string& source, uint32_t importFlags, uint32_t vertexSize);
+
+struct CachedTexture {
+    std::string type;   // "texture_diffuse", ...
+    std::string path;   // relative to the model's directory, as the material names it
+};
+
+// One mesh as handed to writeMeshCache
+struct MeshCacheInput {
+    const void* vertices = nullptr;
+    uint32_t vertexCount = 0;
+    uint32_t vertexFormat = 0;  // opaque to the cache; Mesh stores its VertexFormat
+    uint32_t vertexStride = 0;
+    const void* indices = nullptr;
+    uint32_t indexCount = 0;
+    uint32_t indexSize = 4;     // bytes per index: 2 or 4
+    std::vector<CachedTexture> textures;
+    std::vector<MeshLod> lods;  // ranges of the index block, full detail first
+    std::vector<Meshlet> meshlets;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    bool skinned = false;       // has bone weights; the skeleton is stored once for the model
+};
+
+// The skeleton and clips of animated models, stored after the meshes
+struct MeshCacheAnimation {
+    std::shared_ptr<const Skeleton> skeleton;     // null for static models
+    std::vector<std::shared_ptr<const CompressedClip>> clips;
+};
+
+bool writeMeshCache(const std::string& path, uint64_t key, const std::vector<MeshCacheInput>& meshes,
+                    const MeshCacheAnimation& animation = MeshCacheAnimation(), bool compress = MESH_CACHE_COMPRESSED);
+
+// Read side: a header, a mesh table and the vertex/index blocks, served from
+// a memory mapping. Uncompressed blocks are handed out as pointers into the
+// mapping; compressed ones decode straight into the caller's memory, e.g. a
+// mapped GL buffer.
+class MeshCache {
+public:
+    struct Block {
+        const unsigned char* data = nullptr;
+        size_t stored = 0;      // bytes in the file
+        size_t size = 0;        // bytes once decoded
+
+        bool compressed() const { return stored != size; }
+    };
+
+    struct Entry {
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t vertexFormat = 0;
+        uint32_t vertexStride = 0;
+        uint32_t indexSize = 4;
+        Block vertices;
+        Block indices;
+        std::vector<CachedTexture> textures;
+        std::vector<MeshLod> lods;
+        std::vector<Meshlet> meshlets;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        bool skinned = false;
+    };
+
+    // Fails when the file is missing, damaged or was written for another key
+    bool open(const std::string& path, uint64_t key);
+
+    const std::vector<Entry>& meshes() const { return table; }
+    // Decoded on open; the skeleton is null when the model has none
+    const MeshCacheAnimation& animation() const { return anim; }
+
+    // Copies or decodes a block into `dst`, which must hold block.size bytes
+    static bool read(const Block& block, void* dst);
+
+private:
+    MappedFile file;
+    std::vector<Entry> table;
+    MeshCacheAnimation anim;
+};
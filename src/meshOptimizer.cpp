@@ -0,0 +1,313 @@
+#include "meshOptimizer.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // Forsyth's scoring constants, tuned for a 32-entry LRU model of the cache
+    const int SCORE_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    const unsigned int VALENCE_TABLE_SIZE = 32;
+
+    // Scores only depend on small integers, so they come from tables built once
+    struct ScoreTables {
+        float cache[SCORE_CACHE_SIZE];
+        float valence[VALENCE_TABLE_SIZE];
+
+        ScoreTables() {
+            for (int i = 0; i < SCORE_CACHE_SIZE; i++) {
+                // Just used by the last triangle: a fixed score, so the next
+                // triangle does not simply repeat the same edge
+                float scale = 1.0f / (SCORE_CACHE_SIZE - 3);
+                cache[i] = i < 3 ? LAST_TRIANGLE_SCORE : std::pow(1.0f - (i - 3) * scale, CACHE_DECAY_POWER);
+            }
+            // Vertices with few triangles left get finished off first
+            for (unsigned int i = 0; i < VALENCE_TABLE_SIZE; i++) {
+                valence[i] = i ? VALENCE_BOOST_SCALE * std::pow((float)i, -VALENCE_BOOST_POWER) : 0.0f;
+            }
+        }
+    };
+
+    float vertexScore(const ScoreTables& tables, int cachePosition, unsigned int remaining) {
+        if (remaining == 0) return -1.0f;   // no triangles left to draw it for
+
+        float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+        if (remaining < VALENCE_TABLE_SIZE) return score + tables.valence[remaining];
+        return score + VALENCE_BOOST_SCALE * std::pow((float)remaining, -VALENCE_BOOST_POWER);
+    }
+
+    // Hashes the vertex as 32-bit words; every Vertex field is 4 bytes, so there is no padding
+    uint32_t hashVertex(const Vertex& v) {
+        uint32_t words[sizeof(Vertex) / 4];
+        std::memcpy(words, &v, sizeof(words));
+        uint32_t hash = 0;
+        for (uint32_t word : words) hash = (hash ^ word) * 0x9E3779B1u + (hash >> 15);
+        return hash ^ (hash >> 16);
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indices.size() < 3) return stats;
+
+    // A vertex is still cached if fewer than cacheSize misses happened since it was loaded
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    std::vector<char> referenced(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    size_t misses = 0;
+    size_t unique = 0;
+    for (unsigned int index : indices) {
+        if (time - loadedAt[index] > cacheSize) {
+            loadedAt[index] = time++;
+            misses++;
+        }
+        if (!referenced[index]) {
+            referenced[index] = 1;
+            unique++;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)unique;
+    return stats;
+}
+
+void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    // Open-addressing table of first occurrences, at most half full
+    size_t capacity = 1;
+    while (capacity < vertices.size() * 2) capacity <<= 1;
+    std::vector<unsigned int> table(capacity, UINT_MAX);
+
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        size_t slot = hashVertex(vertices[i]) & (capacity - 1);
+        while (table[slot] != UINT_MAX && std::memcmp(&vertices[table[slot]], &vertices[i], sizeof(Vertex)) != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (table[slot] == UINT_MAX) {
+            table[slot] = (unsigned int)i;
+            remap[i] = (unsigned int)unique.size();
+            unique.push_back(vertices[i]);
+        } else {
+            remap[i] = remap[table[slot]];
+        }
+    }
+
+    for (unsigned int& index : indices) index = remap[index];
+    vertices.swap(unique);
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // Triangles of each vertex (CSR); the first remaining[v] entries are the ones not yet drawn
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices) remaining[index]++;
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+
+    static const ScoreTables tables;
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) score[v] = vertexScore(tables, -1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    }
+
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(SCORE_CACHE_SIZE + 3);
+    nextCache.reserve(SCORE_CACHE_SIZE + 3);
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+
+    size_t cursor = 0;
+    long best = -1;
+    for (size_t drawn = 0; drawn < triangleCount; drawn++) {
+        // Nothing touching the cache is left: restart at the next triangle in input order
+        if (best < 0) {
+            while (emitted[cursor]) cursor++;
+            best = (long)cursor;
+        }
+
+        unsigned int triangle = (unsigned int)best;
+        const unsigned int* corners = &indices[triangle * 3];
+        emitted[triangle] = 1;
+        out.insert(out.end(), corners, corners + 3);
+
+        // Most recently used first
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            if (std::find(nextCache.begin(), nextCache.end(), corners[k]) == nextCache.end()) nextCache.push_back(corners[k]);
+        }
+        for (unsigned int v : cache) {
+            if (v != corners[0] && v != corners[1] && v != corners[2]) nextCache.push_back(v);
+        }
+
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = corners[k];
+            unsigned int* list = &adjacency[offsets[v]];
+            unsigned int* end = list + remaining[v];
+            unsigned int* found = std::find(list, end, triangle);
+            if (found != end) {
+                *found = *(end - 1);
+                remaining[v]--;
+            }
+        }
+
+        // Rescore everything that moved in the cache (including vertices just
+        // pushed out), then pick the best triangle around the cached vertices
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < (size_t)SCORE_CACHE_SIZE ? (int)i : -1;
+            float updated = vertexScore(tables, cachePosition[v], remaining[v]);
+            float delta = updated - score[v];
+            score[v] = updated;
+            for (unsigned int a = 0; a < remaining[v]; a++) triangleScore[adjacency[offsets[v] + a]] += delta;
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        if (nextCache.size() > (size_t)SCORE_CACHE_SIZE) nextCache.resize(SCORE_CACHE_SIZE);
+        for (unsigned int v : nextCache) {
+            for (unsigned int a = 0; a < remaining[v]; a++) {
+                unsigned int candidate = adjacency[offsets[v] + a];
+                if (triangleScore[candidate] > bestScore) {
+                    bestScore = triangleScore[candidate];
+                    best = (long)candidate;
+                }
+            }
+        }
+        cache.swap(nextCache);
+    }
+
+    indices.swap(out);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    float baseline = analyzeVertexCache(indices, vertices.size()).acmr;
+
+    // Cluster boundaries: triangles that miss on all three vertices, where the
+    // cache starts over anyway and reordering costs nothing
+    std::vector<size_t> starts;
+    std::vector<unsigned int> loadedAt(vertices.size(), 0);
+    unsigned int time = VERTEX_CACHE_SIZE + 1;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            unsigned int index = indices[t * 3 + k];
+            if (time - loadedAt[index] > VERTEX_CACHE_SIZE) {
+                loadedAt[index] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) starts.push_back(t);
+    }
+    if (starts.size() < 2) return;
+    starts.push_back(triangleCount);
+
+    struct Cluster {
+        size_t begin, end;
+        glm::vec3 centroid;
+        glm::vec3 normal;       // area-weighted
+        float area;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c + 1 < starts.size(); c++) {
+        Cluster cluster{starts[c], starts[c + 1], glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f};
+        for (size_t t = cluster.begin; t < cluster.end; t++) {
+            const glm::vec3& a = vertices[indices[t * 3]].Position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& c3 = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 n = glm::cross(b - a, c3 - a);
+            float area = glm::length(n);
+            cluster.normal += n;
+            cluster.centroid += (a + b + c3) * (area / 3.0f);
+            cluster.area += area;
+        }
+        meshCentroid += cluster.centroid;
+        meshArea += cluster.area;
+        clusters.push_back(cluster);
+    }
+    if (meshArea <= 0.0f) return;
+    meshCentroid /= meshArea;
+
+    // Clusters facing away from the middle of the mesh are likely in front
+    // of the rest of it from any direction, so they go first
+    for (auto& cluster : clusters) {
+        float length = glm::length(cluster.normal);
+        if (cluster.area <= 0.0f || length <= 0.0f) continue;
+        glm::vec3 centroid = cluster.centroid / cluster.area;
+        cluster.sortKey = glm::dot(centroid - meshCentroid, cluster.normal / length);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    for (auto& cluster : clusters) {
+        out.insert(out.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    if (analyzeVertexCache(out, vertices.size()).acmr <= baseline * threshold) indices.swap(out);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == UINT_MAX) {
+            remap[index] = (unsigned int)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    MeshOptimizeStats stats;
+    stats.verticesBefore = vertices.size();
+    stats.triangles = indices.size() / 3;
+    stats.before = analyzeVertexCache(indices, vertices.size());
+
+    if (!indices.empty() && indices.size() % 3 == 0) {
+        weldVertices(vertices, indices);
+        optimizeVertexCache(indices, vertices.size());
+        optimizeOverdraw(indices, vertices);
+        optimizeVertexFetch(vertices, indices);
+    }
+
+    stats.verticesAfter = vertices.size();
+    stats.after = analyzeVertexCache(indices, vertices.size());
+    return stats;
+}
+
+std::vector<unsigned short> narrowIndices(const std::vector<unsigned int>& indices) {
+    return std::vector<unsigned short>(indices.begin(), indices.end());
+}
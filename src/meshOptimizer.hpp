@@ -0,0 +1,55 @@
+#pragma once
+
+#include "vertexFormat.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#define VERTEX_CACHE_SIZE 16        // FIFO entries assumed by analyzeVertexCache
+#define OVERDRAW_THRESHOLD 1.05f    // overdraw ordering may cost at most 5% ACMR
+
+// Post-transform vertex cache efficiency of an index list, measured with a
+// FIFO cache. ACMR is misses per triangle (0.5 is the ideal for large
+// grids, 3 the worst); ATVR is misses per referenced vertex (1 is ideal).
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                    unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Merges bit-identical vertices and rewrites the indices to match
+void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Reorders triangles for the post-transform cache (Forsyth's linear-speed
+// algorithm); only the order of triangles changes
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Splits a cache-ordered index list into clusters at cache restarts and
+// draws outward-facing clusters first, so more of the mesh is occluded by
+// itself. Keeps the input order if ACMR would grow beyond `threshold`.
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+                      float threshold = OVERDRAW_THRESHOLD);
+
+// Renumbers vertices in first-use order so fetches walk memory linearly;
+// drops vertices no index refers to
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+struct MeshOptimizeStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t triangles = 0;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// All four steps in order; meshes that are not triangle lists are left alone
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Meshes with at most this many vertices draw with 16-bit indices
+#define SHORT_INDEX_LIMIT 65536
+
+inline bool fitsShortIndices(size_t vertexCount) { return vertexCount <= SHORT_INDEX_LIMIT; }
+
+std::vector<unsigned short> narrowIndices(const std::vector<unsigned int>& indices);
@@ -0,0 +1,402 @@
+#include "meshSimplify.hpp"
+#include "meshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const float BORDER_WEIGHT = 10.0f;      // borders resist sliding inward much more than surfaces bend
+    const float MIN_LEVEL_SAVING = 0.85f;   // a level must drop at least 15% of the previous one's triangles
+    const int MAX_PASSES = 64;
+
+    enum VertexKind : unsigned char {
+        Manifold,   // interior: collapses in any direction
+        Border,     // on one open boundary loop: collapses along it
+        Seam,       // on a UV or normal seam with one twin: collapses along it together with the twin
+        Locked,     // seam corner, corner of several borders or non-manifold: never moves
+    };
+
+    // Symmetric 4x4 error quadric; error() is the weighted mean squared
+    // distance to the accumulated planes
+    struct Quadric {
+        float a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+        float b0 = 0, b1 = 0, b2 = 0, c = 0;
+        float w = 0;
+
+        // plane dot(n, p) + d = 0 with unit n
+        static Quadric plane(const glm::vec3& n, float d, float weight) {
+            Quadric q;
+            q.a00 = n.x * n.x * weight; q.a11 = n.y * n.y * weight; q.a22 = n.z * n.z * weight;
+            q.a10 = n.y * n.x * weight; q.a20 = n.z * n.x * weight; q.a21 = n.z * n.y * weight;
+            q.b0 = n.x * d * weight; q.b1 = n.y * d * weight; q.b2 = n.z * d * weight;
+            q.c = d * d * weight;
+            q.w = weight;
+            return q;
+        }
+
+        void add(const Quadric& q) {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+        }
+
+        float error(const glm::vec3& p) const {
+            float rx = a00 * p.x + a10 * p.y + a20 * p.z + b0;
+            float ry = a10 * p.x + a11 * p.y + a21 * p.z + b1;
+            float rz = a20 * p.x + a21 * p.y + a22 * p.z + b2;
+            float e = rx * p.x + ry * p.y + rz * p.z + b0 * p.x + b1 * p.y + b2 * p.z + c;
+            return w > 0.0f ? std::fabs(e) / w : 0.0f;
+        }
+    };
+
+    struct Collapse {
+        unsigned int v0;    // moves onto v1
+        unsigned int v1;
+        float cost;
+    };
+
+    uint64_t edgeKey(unsigned int a, unsigned int b) { return (uint64_t)a << 32 | b; }
+
+    bool positionLess(const glm::vec3& a, const glm::vec3& b) {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.z < b.z;
+    }
+
+    // Vertices sharing a position with another vertex sit on an attribute
+    // seam. Returns the other vertex when exactly two share it, the vertex
+    // itself when more do and ~0u for a position of its own.
+    std::vector<unsigned int> findTwins(const std::vector<glm::vec3>& positions) {
+        std::vector<unsigned int> order(positions.size());
+        for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+            return positionLess(positions[a], positions[b]);
+        });
+
+        std::vector<unsigned int> twin(positions.size(), ~0u);
+        for (size_t i = 0; i < order.size();) {
+            size_t end = i + 1;
+            while (end < order.size() && positions[order[end]] == positions[order[i]]) end++;
+            if (end - i == 2) {
+                twin[order[i]] = order[i + 1];
+                twin[order[i + 1]] = order[i];
+            } else if (end - i > 2) {
+                for (size_t k = i; k < end; k++) twin[order[k]] = order[k];
+            }
+            i = end;
+        }
+        return twin;
+    }
+
+    // Classifies vertices by their open edges: a directed edge is open when
+    // no triangle uses it the other way round. Border and seam vertices get
+    // the neighbours along their loop; the two sides of a seam run in
+    // opposite directions, so a seam vertex's next is its twin's prev.
+    void classify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+                  const std::vector<unsigned int>& twin,
+                  std::vector<VertexKind>& kind, std::vector<unsigned int>& next, std::vector<unsigned int>& prev) {
+        std::vector<uint64_t> edges;
+        edges.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int e = 0; e < 3; e++) edges.push_back(edgeKey(indices[i + e], indices[i + (e + 1) % 3]));
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<unsigned char> openOut(kind.size(), 0), openIn(kind.size(), 0);
+        for (size_t i = 0; i < edges.size(); i++) {
+            unsigned int a = (unsigned int)(edges[i] >> 32), b = (unsigned int)edges[i];
+            if (i > 0 && edges[i] == edges[i - 1]) {
+                openOut[a] = 2;     // the same directed edge twice: non-manifold
+                continue;
+            }
+            if (std::binary_search(edges.begin(), edges.end(), edgeKey(b, a))) continue;
+            openOut[a] = (unsigned char)std::min(openOut[a] + 1, 2);
+            openIn[b] = (unsigned char)std::min(openIn[b] + 1, 2);
+            next[a] = b;
+            prev[b] = a;
+        }
+
+        for (size_t v = 0; v < kind.size(); v++) {
+            unsigned int w = twin[v];
+            if (w == ~0u) {
+                kind[v] = openOut[v] != openIn[v] || openOut[v] > 1 ? Locked : openOut[v] ? Border : Manifold;
+            } else if (w != v && openOut[v] == 1 && openIn[v] == 1 && openOut[w] == 1 && openIn[w] == 1 &&
+                       positions[next[v]] == positions[prev[w]] && positions[prev[v]] == positions[next[w]]) {
+                kind[v] = Seam;
+            } else {
+                kind[v] = Locked;
+            }
+        }
+    }
+
+    std::vector<Quadric> buildQuadrics(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+                                       const std::vector<VertexKind>& kind, const std::vector<unsigned int>& next) {
+        std::vector<Quadric> quadrics(positions.size());
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            unsigned int corner[3] = {indices[i], indices[i + 1], indices[i + 2]};
+            const glm::vec3& p0 = positions[corner[0]];
+            glm::vec3 normal = glm::cross(positions[corner[1]] - p0, positions[corner[2]] - p0);
+            float area = glm::length(normal);
+            if (area <= 0.0f) continue;
+            normal /= area;
+
+            Quadric q = Quadric::plane(normal, -glm::dot(normal, p0), area * 0.5f);
+            for (unsigned int v : corner) quadrics[v].add(q);
+
+            // A plane through each open edge, perpendicular to the face, keeps the border in place
+            for (int e = 0; e < 3; e++) {
+                unsigned int a = corner[e], b = corner[(e + 1) % 3];
+                if (kind[a] == Manifold || next[a] != b) continue;
+                glm::vec3 edge = positions[b] - positions[a];
+                float length = glm::length(edge);
+                if (length <= 0.0f) continue;
+                glm::vec3 n = glm::cross(edge / length, normal);
+                Quadric border = Quadric::plane(n, -glm::dot(n, positions[a]), length * length * BORDER_WEIGHT);
+                quadrics[a].add(border);
+                quadrics[b].add(border);
+            }
+        }
+        return quadrics;
+    }
+
+    bool canCollapse(const std::vector<VertexKind>& kind, const std::vector<unsigned int>& next,
+                     const std::vector<unsigned int>& prev, unsigned int v0, unsigned int v1) {
+        if (kind[v0] == Manifold) return true;
+        if (kind[v0] == Border || kind[v0] == Seam) return next[v0] == v1 || prev[v0] == v1;
+        return false;
+    }
+
+    // Removes v0 from its loop when it moves onto its neighbour v1
+    void splice(std::vector<unsigned int>& next, std::vector<unsigned int>& prev, unsigned int v0, unsigned int v1) {
+        if (next[v0] == v1) {
+            next[prev[v0]] = v1;
+            prev[v1] = prev[v0];
+        } else {
+            prev[next[v0]] = v1;
+            next[v1] = next[v0];
+        }
+    }
+
+    // Moving v0 onto v1 must not turn any of v0's remaining triangles over
+    bool flips(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+               const std::vector<unsigned int>& remap, const std::vector<unsigned int>& triangleOffsets,
+               const std::vector<unsigned int>& triangles, unsigned int v0, unsigned int v1) {
+        const glm::vec3& p0 = positions[v0];
+        const glm::vec3& p1 = positions[v1];
+        for (unsigned int t = triangleOffsets[v0]; t < triangleOffsets[v0 + 1]; t++) {
+            size_t base = (size_t)triangles[t] * 3;
+            unsigned int a = remap[indices[base]], b = remap[indices[base + 1]], c = remap[indices[base + 2]];
+            if (a == v1 || b == v1 || c == v1) continue;     // collapses away
+            if (a == b || b == c || c == a) continue;
+
+            // rotate so v0 comes first, keeping the winding
+            if (b == v0) std::swap(a, b), std::swap(b, c);
+            else if (c == v0) std::swap(a, c), std::swap(b, c);
+            if (a != v0) continue;
+
+            glm::vec3 before = glm::cross(positions[b] - p0, positions[c] - p0);
+            glm::vec3 after = glm::cross(positions[b] - p1, positions[c] - p1);
+            float limit = 0.25f * std::sqrt(glm::dot(before, before) * glm::dot(after, after));
+            if (glm::dot(before, after) <= limit) return true;
+        }
+        return false;
+    }
+
+    // Collapse state over one index list. run() can be called repeatedly
+    // with coarser targets: quadrics keep accumulating, so every error is
+    // measured against the original mesh.
+    class Simplifier {
+    public:
+        std::vector<unsigned int> result;
+
+        Simplifier(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) : result(indices) {
+            n = vertices.size();
+            // Work in a unit box so errors come out relative to the mesh extent
+            glm::vec3 low = vertices[0].Position, high = vertices[0].Position;
+            for (auto& v : vertices) {
+                low = glm::min(low, v.Position);
+                high = glm::max(high, v.Position);
+            }
+            glm::vec3 size = high - low;
+            extent = std::max(size.x, std::max(size.y, size.z));
+            float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+            positions.resize(n);
+            for (size_t i = 0; i < n; i++) positions[i] = (vertices[i].Position - low) * scale;
+
+            kind.resize(n);
+            next.assign(n, ~0u);
+            prev.assign(n, ~0u);
+            twin = findTwins(positions);
+            classify(positions, result, twin, kind, next, prev);
+            quadrics = buildQuadrics(positions, result, kind, next);
+
+            remap.resize(n);
+            for (unsigned int i = 0; i < n; i++) remap[i] = i;
+            touched.assign(n, 0);
+            triangleOffsets.resize(n + 1);
+        }
+
+        float Extent() const { return extent; }
+
+        // Collapses until `targetIndexCount` or the error bound; returns the error reached so far
+        float run(size_t targetIndexCount, float targetError) {
+            float errorLimit = targetError * targetError;
+            for (int pass = 0; pass < MAX_PASSES && result.size() > targetIndexCount; pass++) {
+                if (!collapsePass(targetIndexCount, errorLimit)) break;
+            }
+            return std::sqrt(reached);
+        }
+
+    private:
+        size_t n = 0;
+        float extent = 0.0f;
+        float reached = 0.0f;
+        std::vector<glm::vec3> positions;
+        std::vector<VertexKind> kind;
+        std::vector<unsigned int> next, prev, twin;
+        std::vector<Quadric> quadrics;
+        std::vector<unsigned int> remap;
+        std::vector<char> touched;
+        std::vector<unsigned int> triangleOffsets, triangles;
+        std::vector<uint64_t> edges;
+        std::vector<Collapse> collapses;
+
+        // Where the twin of seam vertex v0 goes when v0 moves onto v1: the
+        // twin's neighbour at v1's position, or ~0u if the seam has no such edge
+        unsigned int twinTarget(unsigned int v0, unsigned int v1) const {
+            unsigned int w0 = twin[v0];
+            unsigned int w1 = next[v0] == v1 ? prev[w0] : next[w0];
+            if (w1 == ~0u || w1 == v0 || w1 == v1 || positions[w1] != positions[v1]) return ~0u;
+            return w1;
+        }
+
+        // Cost of moving v0 onto v1, seam twins included
+        float cost(unsigned int v0, unsigned int v1) const {
+            float error = quadrics[v0].error(positions[v1]);
+            if (kind[v0] != Seam) return error;
+            unsigned int w1 = twinTarget(v0, v1);
+            return w1 == ~0u ? INFINITY : error + quadrics[twin[v0]].error(positions[w1]);
+        }
+
+        bool collapsePass(size_t targetIndexCount, float errorLimit) {
+            // vertex -> triangle adjacency of the current index list
+            std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+            for (unsigned int index : result) triangleOffsets[index + 1]++;
+            for (size_t i = 0; i < n; i++) triangleOffsets[i + 1] += triangleOffsets[i];
+            triangles.resize(result.size());
+            std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) triangles[fill[result[i]]++] = (unsigned int)(i / 3);
+
+            // each undirected edge once, in its cheaper allowed direction
+            edges.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+                    edges.push_back(edgeKey(std::min(a, b), std::max(a, b)));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            collapses.clear();
+            for (uint64_t edge : edges) {
+                unsigned int a = (unsigned int)(edge >> 32), b = (unsigned int)edge;
+                bool ab = canCollapse(kind, next, prev, a, b);
+                bool ba = canCollapse(kind, next, prev, b, a);
+                if (!ab && !ba) continue;
+                float costAB = ab ? cost(a, b) : INFINITY;
+                float costBA = ba ? cost(b, a) : INFINITY;
+                // infinite means not allowed (a seam edge its twin has no match for), whatever the bound
+                float cheaper = std::min(costAB, costBA);
+                if (!std::isfinite(cheaper) || cheaper > errorLimit) continue;
+                if (costAB <= costBA) collapses.push_back({a, b, costAB});
+                else collapses.push_back({b, a, costBA});
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            // cheapest first; a vertex takes part in one collapse per pass
+            size_t goal = (result.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+            size_t applied = 0;
+            std::fill(touched.begin(), touched.end(), 0);
+            for (const Collapse& c : collapses) {
+                if (removed >= goal) break;
+                if (touched[c.v0] || touched[c.v1]) continue;
+                if (flips(positions, result, remap, triangleOffsets, triangles, c.v0, c.v1)) continue;
+
+                // a seam vertex takes its twin along, one triangle off each side
+                if (kind[c.v0] == Seam) {
+                    unsigned int w0 = twin[c.v0], w1 = twinTarget(c.v0, c.v1);
+                    if (w1 == ~0u || touched[w0] || touched[w1]) continue;
+                    if (flips(positions, result, remap, triangleOffsets, triangles, w0, w1)) continue;
+                    splice(next, prev, w0, w1);
+                    remap[w0] = w1;
+                    quadrics[w1].add(quadrics[w0]);
+                    touched[w0] = touched[w1] = 1;
+                }
+
+                // a border or seam collapse shortens the loop; splice v0 out of it
+                if (kind[c.v0] != Manifold) splice(next, prev, c.v0, c.v1);
+                remap[c.v0] = c.v1;
+                quadrics[c.v1].add(quadrics[c.v0]);
+                touched[c.v0] = touched[c.v1] = 1;
+                reached = std::max(reached, c.cost);
+                removed += kind[c.v0] == Border ? 1 : 2;
+                applied++;
+            }
+            if (!applied) return false;
+
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (a == b || b == c || c == a) continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+            for (unsigned int i = 0; i < n; i++) remap[i] = i;
+            return true;
+        }
+    };
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       size_t targetIndexCount, float targetError, float* resultError) {
+    if (resultError) *resultError = 0.0f;
+    if (vertices.empty() || indices.size() % 3 != 0 || indices.size() <= targetIndexCount) return indices;
+
+    Simplifier simplifier(vertices, indices);
+    float error = simplifier.run(targetIndexCount, targetError);
+    if (resultError) *resultError = error;
+    return std::move(simplifier.result);
+}
+
+std::vector<MeshLod> buildLodChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<MeshLod> lods(1);
+    lods[0].indexCount = (uint32_t)indices.size();
+    if (vertices.empty() || indices.size() % 3 != 0 || indices.size() < LOD_MIN_TRIANGLES * 3) return lods;
+
+    // One progressive run: each level continues from the one before
+    Simplifier simplifier(vertices, indices);
+    size_t previous = indices.size();
+    float bound = LOD_BASE_ERROR;
+    for (int level = 1; level < LOD_MAX_LEVELS; level++, bound *= 2.0f) {
+        size_t target = (size_t)(previous / 3 * LOD_TRIANGLE_RATIO) * 3;
+        if (target < LOD_MIN_TRIANGLES * 3) break;
+
+        float error = simplifier.run(target, bound);
+        if (simplifier.result.empty() || simplifier.result.size() > previous * MIN_LEVEL_SAVING) break;
+        std::vector<unsigned int> lodIndices = simplifier.result;
+        optimizeVertexCache(lodIndices, vertices.size());
+
+        MeshLod lod;
+        lod.firstIndex = (uint32_t)indices.size();
+        lod.indexCount = (uint32_t)lodIndices.size();
+        lod.error = error * simplifier.Extent();
+        lods.push_back(lod);
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        previous = lodIndices.size();
+    }
+    return lods;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vertexFormat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define LOD_MAX_LEVELS 5            // including the full-detail mesh
+#define LOD_TRIANGLE_RATIO 0.5f     // each level aims for half the triangles of the one before
+#define LOD_BASE_ERROR 0.005f       // error bound of level 1, doubling per level; relative to the mesh extent
+#define LOD_MIN_TRIANGLES 32        // no level is built below this
+
+// One level of detail: a range of the mesh's index list. All levels share
+// the vertex array; `error` is the largest deviation from the full mesh in
+// object-space units. Meshlets, when built, cover the range in order.
+struct MeshLod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+};
+
+// Quadric-error edge collapse (Garland & Heckbert) onto existing vertices,
+// so the result indexes the same vertex array. Border vertices only slide
+// along their border; UV or normal seams collapse along themselves, both
+// sides at once, and only seam corners stay put. Stops at
+// `targetIndexCount` or once a collapse would cost more than `targetError`
+// (relative to the mesh extent); `resultError` gets the error reached.
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+// Appends up to LOD_MAX_LEVELS - 1 coarser, cache-optimized index lists to
+// `indices` and returns every level, the full mesh first. The chain ends
+// early when a level would not save enough triangles within its error bound.
+std::vector<MeshLod> buildLodChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
@@ -0,0 +1,121 @@
+#include "meshlet.hpp"
+
+#include <cmath>
+
+namespace {
+    const float MIN_CONE_DOT = 0.1f;    // wider cones than ~84 degrees never cull anything useful
+
+    void computeBounds(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, Meshlet& m) {
+        glm::vec3 low = vertices[indices[m.firstIndex]].Position, high = low;
+        for (uint32_t i = m.firstIndex; i < m.firstIndex + m.indexCount; i++) {
+            low = glm::min(low, vertices[indices[i]].Position);
+            high = glm::max(high, vertices[indices[i]].Position);
+        }
+        m.center = (low + high) * 0.5f;
+        float radius2 = 0.0f;
+        for (uint32_t i = m.firstIndex; i < m.firstIndex + m.indexCount; i++) {
+            glm::vec3 d = vertices[indices[i]].Position - m.center;
+            radius2 = std::max(radius2, glm::dot(d, d));
+        }
+        m.radius = std::sqrt(radius2);
+
+        // Cone around the average face normal, as wide as the least aligned face
+        std::vector<glm::vec3> normals;
+        normals.reserve(m.indexCount / 3);
+        glm::vec3 sum(0.0f);
+        for (uint32_t i = m.firstIndex; i < m.firstIndex + m.indexCount; i += 3) {
+            const glm::vec3& p0 = vertices[indices[i]].Position;
+            glm::vec3 n = glm::cross(vertices[indices[i + 1]].Position - p0, vertices[indices[i + 2]].Position - p0);
+            float length = glm::length(n);
+            if (length <= 0.0f) continue;
+            normals.push_back(n / length);
+            sum += normals.back();
+        }
+        float sumLength = glm::length(sum);
+        m.coneCutoff = 1.0f;
+        if (normals.empty() || sumLength <= 0.0f) return;
+        m.coneAxis = sum / sumLength;
+
+        float minDot = 1.0f;
+        for (auto& n : normals) minDot = std::min(minDot, glm::dot(n, m.coneAxis));
+        if (minDot <= MIN_CONE_DOT) return;
+        m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+void buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                   uint32_t first, uint32_t count, std::vector<Meshlet>& out) {
+    // last meshlet each vertex was counted in, so the distinct count is one lookup per corner
+    std::vector<uint32_t> seenIn(vertices.size(), ~0u);
+    uint32_t id = (uint32_t)out.size();
+
+    Meshlet current;
+    current.firstIndex = first;
+    for (uint32_t i = first; i + 2 < first + count; i += 3) {
+        unsigned int corner[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        uint32_t added = 0;
+        for (int k = 0; k < 3; k++) {
+            bool repeat = (k > 0 && corner[k] == corner[0]) || (k > 1 && corner[k] == corner[1]);
+            if (seenIn[corner[k]] != id && !repeat) added++;
+        }
+        if (current.vertexCount + added > MESHLET_MAX_VERTICES || current.indexCount / 3 >= MESHLET_MAX_TRIANGLES) {
+            computeBounds(vertices, indices, current);
+            out.push_back(current);
+            id++;
+            current = Meshlet();
+            current.firstIndex = i;
+            added = 0;
+            for (int k = 0; k < 3; k++) {
+                bool repeat = (k > 0 && corner[k] == corner[0]) || (k > 1 && corner[k] == corner[1]);
+                if (!repeat) added++;
+            }
+        }
+        for (unsigned int v : corner) seenIn[v] = id;
+        current.vertexCount += added;
+        current.indexCount += 3;
+    }
+    if (current.indexCount) {
+        computeBounds(vertices, indices, current);
+        out.push_back(current);
+    }
+}
+
+MeshletView meshletView(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& cameraPos,
+                        bool cullBackfaces) {
+    MeshletView view;
+    view.backfaces = cullBackfaces;
+
+    // Planes of the clip volume pulled back through model-view-projection
+    // (Gribb & Hartmann) land in object space directly
+    glm::mat4 m = viewProjection * model;
+    glm::vec4 row[4];
+    for (int r = 0; r < 4; r++) row[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+    view.planes[0] = row[3] + row[0];
+    view.planes[1] = row[3] - row[0];
+    view.planes[2] = row[3] + row[1];
+    view.planes[3] = row[3] - row[1];
+    view.planes[4] = row[3] + row[2];
+    view.planes[5] = row[3] - row[2];
+    for (auto& plane : view.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane = plane / length;
+    }
+
+    view.camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+    return view;
+}
+
+MeshletCull cullMeshlet(const Meshlet& meshlet, const MeshletView& view) {
+    for (auto& plane : view.planes) {
+        if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) return MeshletCull::Frustum;
+    }
+    // Sidedness survives any affine transform, so the object-space test holds
+    // under rotation and non-uniform scale alike
+    if (view.backfaces) {
+        glm::vec3 toCenter = meshlet.center - view.camera;
+        if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius) {
+            return MeshletCull::Backface;
+        }
+    }
+    return MeshletCull::Visible;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "vertexFormat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// A run of consecutive triangles in a mesh's index list, with the bounds
+// the per-frame culling pass tests against. Object space.
+struct Meshlet {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t vertexCount = 0;           // distinct vertices referenced
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f);
+    float coneCutoff = 1.0f;            // sine of the normal cone's half angle; 1 never culls
+};
+
+// Splits indices[first, first + count) into meshlets, keeping triangle order.
+// The lists are vertex-cache ordered, so neighbouring triangles are already
+// spatially close and share vertices.
+void buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                   uint32_t first, uint32_t count, std::vector<Meshlet>& out);
+
+// The camera in a mesh's object space: frustum planes (normalized, inside
+// positive) and position
+struct MeshletView {
+    glm::vec4 planes[6];
+    glm::vec3 camera = glm::vec3(0.0f);
+    bool backfaces = true;              // cone-cull clusters facing away
+};
+
+MeshletView meshletView(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& cameraPos,
+                        bool cullBackfaces = true);
+
+enum class MeshletCull { Visible, Frustum, Backface };
+
+MeshletCull cullMeshlet(const Meshlet& meshlet, const MeshletView& view);
+
+struct MeshletCullStats {
+    size_t meshlets = 0;
+    size_t frustumCulled = 0;
+    size_t backfaceCulled = 0;
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter = 0;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+
+    void add(const MeshletCullStats& o) {
+        meshlets += o.meshlets;
+        frustumCulled += o.frustumCulled;
+        backfaceCulled += o.backfaceCulled;
+        trianglesBefore += o.trianglesBefore;
+        trianglesAfter += o.trianglesAfter;
+        verticesBefore += o.verticesBefore;
+        verticesAfter += o.verticesAfter;
+    }
+};
+
+// Totals over every mesh culled in a frame; the renderer rolls them over
+class MeshletCulling {
+public:
+    static void record(const MeshletCullStats& stats) { current.add(stats); }
+    static const MeshletCullStats& lastFrame() { return last; }
+    static void beginFrame() {
+        last = current;
+        current = MeshletCullStats();
+    }
+private:
+    inline static MeshletCullStats current;
+    inline static MeshletCullStats last;
+};
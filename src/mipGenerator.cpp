@@ -0,0 +1,224 @@
+#include "mipGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_SSE2 1
+#endif
+
+namespace {
+    DecodedImage allocate(int width, int height, int channels) {
+        DecodedImage image;
+        image.width = width;
+        image.height = height;
+        image.channels = channels;
+        image.pixels = std::shared_ptr<unsigned char>(new unsigned char[image.size()], std::default_delete<unsigned char[]>());
+        return image;
+    }
+
+    const int SRGB_BUCKETS = 4096;
+
+    struct SrgbTables {
+        float toLinear[256];
+        float thresholds[256];              // linear midpoints between neighbouring sRGB codes
+        unsigned char start[SRGB_BUCKETS];  // lowest code reachable from each linear bucket
+
+        SrgbTables() {
+            for (int i = 0; i < 256; i++) {
+                toLinear[i] = decode(i / 255.0f);
+                thresholds[i] = i < 255 ? decode((i + 0.5f) / 255.0f) : 2.0f;
+            }
+            int code = 0;
+            for (int i = 0; i < SRGB_BUCKETS; i++) {
+                while (thresholds[code] <= (float)i / SRGB_BUCKETS) code++;
+                start[i] = (unsigned char)code;
+            }
+        }
+
+        static float decode(float c) {
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        // Exact rounding back to 8-bit sRGB: bucket lookup, then a step or two
+        unsigned char encode(float linear) const {
+            int bucket = std::clamp((int)(linear * SRGB_BUCKETS), 0, SRGB_BUCKETS - 1);
+            int code = start[bucket];
+            while (thresholds[code] <= linear) code++;
+            return (unsigned char)code;
+        }
+    };
+
+    const SrgbTables& srgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    // Generic path: any channel count, clamped edges
+    void downsampleRowScalar(const unsigned char* row0, const unsigned char* row1, int srcWidth, int channels,
+                             bool srgb, int begin, int end, unsigned char* out) {
+        const SrgbTables& tables = srgbTables();
+        int colorChannels = srgb && channels >= 3 ? 3 : 0;
+        for (int x = begin; x < end; x++) {
+            int x0 = std::min(x * 2, srcWidth - 1) * channels;
+            int x1 = std::min(x * 2 + 1, srcWidth - 1) * channels;
+            for (int c = 0; c < channels; c++) {
+                if (c < colorChannels) {
+                    float sum = tables.toLinear[row0[x0 + c]] + tables.toLinear[row0[x1 + c]] +
+                                tables.toLinear[row1[x0 + c]] + tables.toLinear[row1[x1 + c]];
+                    out[x * channels + c] = tables.encode(sum * 0.25f);
+                } else {
+                    int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                    out[x * channels + c] = (unsigned char)((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
+#ifdef MIP_SSE2
+    // Four RGBA output texels per step from 2 x 32 source bytes
+    int downsampleRowRGBA(const unsigned char* row0, const unsigned char* row1, int outWidth, unsigned char* out) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(2);
+        int x = 0;
+        for (; x + 4 <= outWidth; x += 4) {
+            __m128i result[2];
+            for (int half = 0; half < 2; half++) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + half * 16));
+                __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + half * 16));
+                // Vertical sums of texel pairs (0,1) and (2,3), 16 bits per channel
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                // Horizontal: fold each pair into one texel
+                lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                __m128i sum = _mm_unpacklo_epi64(lo, hi);
+                result[half] = _mm_srli_epi16(_mm_add_epi16(sum, bias), 2);
+            }
+            _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(result[0], result[1]));
+        }
+        return x;
+    }
+
+    // sRGB RGBA: alpha as above, color summed in linear light four output
+    // texels at a time, in the scalar path's order so both round the same
+    int downsampleRowRGBALinear(const unsigned char* row0, const unsigned char* row1, int outWidth, unsigned char* out) {
+        int done = downsampleRowRGBA(row0, row1, outWidth, out);
+        const SrgbTables& tables = srgbTables();
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        const __m128 bucketScale = _mm_set1_ps((float)SRGB_BUCKETS);
+        const __m128 lastBucket = _mm_set1_ps((float)(SRGB_BUCKETS - 1));
+        const __m128i one = _mm_set1_epi32(1);
+        alignas(16) int32_t bucket[4], code[4];
+        for (int x = 0; x < done; x += 4) {
+            const unsigned char* a = row0 + x * 8;
+            const unsigned char* b = row1 + x * 8;
+            for (int c = 0; c < 3; c++) {
+                // lane k is output texel x + k; `texel` picks the left or right source of each pair
+                auto load = [&](const unsigned char* row, int texel) {
+                    return _mm_set_ps(tables.toLinear[row[(6 + texel) * 4 + c]], tables.toLinear[row[(4 + texel) * 4 + c]],
+                                      tables.toLinear[row[(2 + texel) * 4 + c]], tables.toLinear[row[texel * 4 + c]]);
+                };
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(load(a, 0), load(a, 1)), load(b, 0)), load(b, 1));
+                __m128 linear = _mm_mul_ps(sum, quarter);
+
+                // SrgbTables::encode without the branch: no bucket spans two
+                // thresholds, so its loop takes at most one step
+                __m128 scaled = _mm_min_ps(_mm_max_ps(_mm_mul_ps(linear, bucketScale), _mm_setzero_ps()), lastBucket);
+                _mm_store_si128((__m128i*)bucket, _mm_cvttps_epi32(scaled));
+                for (int k = 0; k < 4; k++) code[k] = tables.start[bucket[k]];
+                __m128 threshold = _mm_set_ps(tables.thresholds[code[3]], tables.thresholds[code[2]],
+                                              tables.thresholds[code[1]], tables.thresholds[code[0]]);
+                __m128i step = _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(threshold, linear)), one);
+                _mm_store_si128((__m128i*)code, _mm_add_epi32(_mm_load_si128((const __m128i*)code), step));
+                for (int k = 0; k < 4; k++) out[(x + k) * 4 + c] = (unsigned char)code[k];
+            }
+        }
+        return done;
+    }
+
+    // Sixteen single-channel output texels per step
+    int downsampleRowR(const unsigned char* row0, const unsigned char* row1, int outWidth, unsigned char* out) {
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        const __m128i bias = _mm_set1_epi16(2);
+        int x = 0;
+        for (; x + 16 <= outWidth; x += 16) {
+            __m128i result[2];
+            for (int half = 0; half < 2; half++) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 2 + half * 16));
+                __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 2 + half * 16));
+                // Even + odd bytes of each row, widened to 16 bits
+                __m128i sumA = _mm_add_epi16(_mm_and_si128(a, lowBytes), _mm_srli_epi16(a, 8));
+                __m128i sumB = _mm_add_epi16(_mm_and_si128(b, lowBytes), _mm_srli_epi16(b, 8));
+                result[half] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sumA, sumB), bias), 2);
+            }
+            _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(result[0], result[1]));
+        }
+        return x;
+    }
+#endif
+}
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    int size = std::max(width, height);
+    while (size > 1) {
+        size /= 2;
+        levels++;
+    }
+    return levels;
+}
+
+DecodedImage downsampleImage(const DecodedImage& src, bool srgb) {
+    int channels = src.channels;
+    DecodedImage dst = allocate(std::max(1, src.width / 2), std::max(1, src.height / 2), channels);
+    bool colorFilter = srgb && channels >= 3;
+
+    const unsigned char* pixels = src.pixels.get();
+    size_t srcStride = (size_t)src.width * channels;
+    size_t dstStride = (size_t)dst.width * channels;
+    for (int y = 0; y < dst.height; y++) {
+        const unsigned char* row0 = pixels + std::min(y * 2, src.height - 1) * srcStride;
+        const unsigned char* row1 = pixels + std::min(y * 2 + 1, src.height - 1) * srcStride;
+        unsigned char* out = dst.pixels.get() + y * dstStride;
+
+        // SIMD needs both texels of every horizontal pair, i.e. a source wider than 1
+        int done = 0;
+#ifdef MIP_SSE2
+        if (src.width > 1 && channels == 4) {
+            done = colorFilter ? downsampleRowRGBALinear(row0, row1, dst.width, out) : downsampleRowRGBA(row0, row1, dst.width, out);
+        }
+        if (src.width > 1 && channels == 1) done = downsampleRowR(row0, row1, dst.width, out);
+#endif
+        downsampleRowScalar(row0, row1, src.width, channels, colorFilter, done, dst.width, out);
+    }
+    return dst;
+}
+
+std::vector<DecodedImage> buildMipChain(const DecodedImage& base, bool srgb) {
+    std::vector<DecodedImage> chain;
+    chain.reserve(mipLevelCount(base.width, base.height));
+    chain.push_back(base);
+    while (chain.back().width > 1 || chain.back().height > 1) {
+        chain.push_back(downsampleImage(chain.back(), srgb));
+    }
+    return chain;
+}
+
+DecodedImage expandToRGBA(const DecodedImage& image) {
+    if (image.channels != 3) return image;
+
+    DecodedImage out = allocate(image.width, image.height, 4);
+    const unsigned char* src = image.pixels.get();
+    unsigned char* dst = out.pixels.get();
+    size_t count = (size_t)image.width * image.height;
+    for (size_t i = 0; i < count; i++) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 255;
+    }
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "imageDecode.hpp"
+
+#include <vector>
+
+// CPU mip-chain generation with a 2x2 box filter. Results are bit-exact on
+// every machine, unlike glGenerateMipmap, and the work runs off the GL
+// thread. RGBA and single-channel images take an SSE2 path when available.
+//
+// With `srgb`, RGB is averaged in linear light and re-encoded; alpha and
+// one/two-channel images are always filtered as linear data.
+
+int mipLevelCount(int width, int height);
+
+// One level down: floor(width / 2) x floor(height / 2), at least 1x1
+DecodedImage downsampleImage(const DecodedImage& src, bool srgb);
+
+// Level 0 (sharing `base`'s pixels) down to 1x1
+std::vector<DecodedImage> buildMipChain(const DecodedImage& base, bool srgb);
+
+// RGB -> RGBA with opaque alpha, so rows stay 4-byte aligned and the SIMD
+// path applies; GL still stores the texture as RGB
+DecodedImage expandToRGBA(const DecodedImage& image);
@@ -9,55 +9,431 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include <stb/stb_image.h>
+#include "textureCache.hpp"
+#include "meshCache.hpp"
+#include "processMemory.hpp"
+#include "threadPool.hpp"
+#include "animation.hpp"
+#include "animationCompress.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+// Part of the mesh cache key: changing them re-imports the model
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
 
 unsigned int TextureFromFile(const char *path, const std::string &directory);
 
 class ModelLoader {
 public:
-    ModelLoader(char *path) {
+    ModelLoader(char *path, MeshResidency residency = MeshResidency::None) : residency(residency) {
         loadModel(path);
+        reportMemory(path);
     }
     void Draw(Shader &shader) {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        // Meshes are sorted so each run sharing a pool and material is one bind and one multi-draw
+        for (size_t i = 0; i < meshes.size();) {
+            size_t end = i + 1;
+            while (end < meshes.size() && meshes[end].BatchesWith(meshes[i])) end++;
+
+            meshes[i].BindMaterial(shader);
+            drawHandles.clear();
+            drawRanges.clear();
+            for (size_t j = i; j < end; j++) {
+                for (const IndexRange& range : meshes[j].VisibleRanges()) {
+                    drawHandles.push_back(meshes[j].Geometry());
+                    drawRanges.push_back(range);
+                }
+            }
+            GeometryHeap::drawRanges(drawHandles.data(), drawRanges.data(), drawHandles.size());
+            i = end;
+        }
     }  
+    void SelectLods(float errorScale) {
+        for (auto& mesh : meshes) mesh.SelectLod(errorScale);
+    }
+    void CullMeshlets(const MeshletView& view) {
+        // meshlet bounds are in the bind pose, which skinned vertices leave
+        if (skeleton) return;
+        MeshletCullStats stats;
+        for (auto& mesh : meshes) mesh.CullMeshlets(view, stats);
+        MeshletCulling::record(stats);
+    }
+    // Object-space bounding sphere around every mesh's box
+    glm::vec3 BoundsCenter() const { return boundsCenter; }
+    float BoundsRadius() const { return boundsRadius; }
+    void cleanup() {
+        for (auto& mesh : meshes) mesh.Release();
+        meshes.clear();
+    }
+    uint64_t LayoutKey() const { return meshes.empty() ? 0 : meshes[0].LayoutKey(); }
+    // Bone weights, a skeleton and at least one clip to play
+    bool IsAnimated() const { return skeleton && !clips.empty(); }
+    std::shared_ptr<const Skeleton> GetSkeleton() const { return skeleton; }
+    const std::vector<std::shared_ptr<const CompressedClip>>& Clips() const { return clips; }
+    // For objects that draw the imported data their own way (Crowd)
+    std::vector<Mesh>& Meshes() { return meshes; }
+    bool HasTexture(const std::string& type) const {
+        for (auto& mesh : meshes) {
+            for (auto& tex : mesh.textures) {
+                if (tex.type == type) return true;
+            }
+        }
+        return false;
+    }
 private:
-    std::vector<Tex> textures_loaded;
     std::vector<Mesh> meshes;
+    std::vector<GeometryHandle> drawHandles;
+    std::vector<IndexRange> drawRanges;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
     std::string directory;
+    MeshResidency residency;
+    MeshOptimizeStats optimizeTotals;     // triangle-weighted over the whole import
+    std::shared_ptr<const Skeleton> skeleton;   // only when some mesh has bones
+    std::vector<std::shared_ptr<const CompressedClip>> clips;
+    ClipCompressionStats compressionTotals;
 
     void loadModel(std::string path) {
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // Warm loads map the processed meshes, skeleton and clips and skip Assimp entirely
+        uint64_t key = meshCacheKey(path, MODEL_IMPORT_FLAGS, sizeof(Vertex));
+        if (key && loadCached(meshCachePath(path), key)) {
+            reportAnimation(path);
+            computeBounds();
+            sortForBatching();
+            return;
+        }
+
         Assimp::Importer import;
-        const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);	
+        const aiScene *scene = import.ReadFile(path, MODEL_IMPORT_FLAGS);
         
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
             std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
             return;
         }
-        directory = path.substr(0, path.find_last_of('/'));
 
-        processNode(scene->mRootNode, scene);
+        importScene(scene, path, key);
+        computeBounds();
+        sortForBatching();
     }  
-    void processNode(aiNode *node, const aiScene *scene) {
-        // process all the node's meshes (if any)
+    // CPU stage on the pool: convert, optimize, generate tangents and pack every mesh.
+    // Texture decodes are requested meanwhile and run on the same workers. The GL
+    // stage after it only allocates and uploads.
+    void importScene(const aiScene* scene, const std::string& path, uint64_t key) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<const aiMesh*> sources;
+        collectMeshes(scene->mRootNode, scene, sources);
+        // palette slots are fixed before the jobs, which only look them up
+        std::unordered_map<std::string, int> bones = importSkeleton(scene);
+
+        std::vector<PreparedMesh> prepared(sources.size());
+        std::vector<std::future<void>> jobs;
+        jobs.reserve(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            jobs.push_back(ThreadPool::shared().submit([&prepared, &sources, &bones, i] {
+                prepared[i] = processMesh(sources[i], bones);
+            }));
+        }
+        importAnimations(scene);
+
+        // materials are shared between meshes; resolve each one once
+        std::vector<std::vector<Tex>> materials(scene->mNumMaterials);
+        std::vector<bool> resolved(scene->mNumMaterials, false);
+        for (auto* mesh : sources) {
+            if (resolved[mesh->mMaterialIndex]) continue;
+            materials[mesh->mMaterialIndex] = processMaterial(scene->mMaterials[mesh->mMaterialIndex]);
+            resolved[mesh->mMaterialIndex] = true;
+        }
+        for (auto& job : jobs) job.get();
+        auto converted = std::chrono::steady_clock::now();
+
+        meshes.reserve(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            accumulate(prepared[i].stats);
+            meshes.emplace_back(prepared[i], materials[sources[i]->mMaterialIndex], residency);
+        }
+        auto uploaded = std::chrono::steady_clock::now();
+
+        auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+        std::cout << "Imported " << path << ": " << sources.size() << " meshes, CPU "
+                  << ms(start, converted) << " ms on " << ThreadPool::shared().size() << " threads, GL "
+                  << ms(converted, uploaded) << " ms" << std::endl;
+        reportOptimization(path);
+        reportLods(path, prepared);
+        reportAnimation(path);
+
+        // The cache only needs the packed streams, so it is written in the background
+        if (key) {
+            auto streams = std::make_shared<std::vector<PreparedMesh>>(std::move(prepared));
+            // type and path only: texture handles must not be released off the GL thread
+            std::vector<std::vector<CachedTexture>> textures(meshes.size());
+            for (size_t i = 0; i < meshes.size(); i++) {
+                for (auto& tex : meshes[i].textures) textures[i].push_back({tex.type, tex.path});
+            }
+            MeshCacheAnimation animation{skeleton, clips};
+            ThreadPool::shared().submit([cachePath = meshCachePath(path), key, streams, textures, animation] {
+                writeCache(cachePath, key, *streams, textures, animation);
+            });
+        }
+    }
+    void reportMemory(const std::string& path) const {
+        size_t cpuBytes = 0;
+        for (auto& mesh : meshes) cpuBytes += mesh.CpuBytes();
+        std::cout << "Loaded " << path << ": " << meshes.size() << " meshes, "
+                  << cpuBytes / (1024.0 * 1024.0) << " MB kept on the CPU, RSS "
+                  << currentResidentBytes() / (1024.0 * 1024.0) << " MB (peak "
+                  << peakResidentBytes() / (1024.0 * 1024.0) << " MB)" << std::endl;
+    }
+    void computeBounds() {
+        if (meshes.empty()) return;
+        glm::vec3 low = meshes[0].boundsMin, high = meshes[0].boundsMax;
+        for (auto& mesh : meshes) {
+            low = glm::min(low, mesh.boundsMin);
+            high = glm::max(high, mesh.boundsMax);
+        }
+        boundsCenter = (low + high) * 0.5f;
+        boundsRadius = glm::length(high - low) * 0.5f;
+    }
+    void sortForBatching() {
+        auto materialKey = [](const Mesh& mesh) {
+            std::vector<unsigned int> ids;
+            for (auto& tex : mesh.textures) ids.push_back(tex.id);
+            return ids;
+        };
+        std::stable_sort(meshes.begin(), meshes.end(), [&](const Mesh& a, const Mesh& b) {
+            uint32_t poolA = GeometryHeap::pool(a.Geometry());
+            uint32_t poolB = GeometryHeap::pool(b.Geometry());
+            if (poolA != poolB) return poolA < poolB;
+            return materialKey(a) < materialKey(b);
+        });
+    }
+    void accumulate(const MeshOptimizeStats& stats) {
+        MeshOptimizeStats& t = optimizeTotals;
+        auto blend = [](float total, size_t weight, float value, size_t added) {
+            return weight + added ? (total * weight + value * added) / (float)(weight + added) : 0.0f;
+        };
+        t.before.acmr = blend(t.before.acmr, t.triangles, stats.before.acmr, stats.triangles);
+        t.after.acmr = blend(t.after.acmr, t.triangles, stats.after.acmr, stats.triangles);
+        t.before.atvr = blend(t.before.atvr, t.verticesBefore, stats.before.atvr, stats.verticesBefore);
+        t.after.atvr = blend(t.after.atvr, t.verticesAfter, stats.after.atvr, stats.verticesAfter);
+        t.triangles += stats.triangles;
+        t.verticesBefore += stats.verticesBefore;
+        t.verticesAfter += stats.verticesAfter;
+    }
+    void reportOptimization(const std::string& path) const {
+        const MeshOptimizeStats& t = optimizeTotals;
+        if (!t.triangles) return;
+        std::cout << "Optimized " << path << ": " << t.triangles << " triangles, "
+                  << t.verticesBefore << " -> " << t.verticesAfter << " vertices, ACMR "
+                  << t.before.acmr << " -> " << t.after.acmr << ", ATVR "
+                  << t.before.atvr << " -> " << t.after.atvr << std::endl;
+    }
+    // Triangles per level over all meshes; meshes with shorter chains count their coarsest level
+    void reportLods(const std::string& path, const std::vector<PreparedMesh>& prepared) const {
+        std::vector<size_t> triangles(LOD_MAX_LEVELS, 0);
+        for (auto& mesh : prepared) {
+            for (size_t level = 0; level < triangles.size(); level++) {
+                triangles[level] += mesh.lods[std::min(level, mesh.lods.size() - 1)].indexCount / 3;
+            }
+        }
+        std::cout << "LODs for " << path << ":";
+        for (size_t level = 0; level < triangles.size(); level++) std::cout << " " << triangles[level];
+        std::cout << " triangles" << std::endl;
+    }
+    bool loadCached(const std::string& cachePath, uint64_t key) {
+        MeshCache cache;
+        if (!cache.open(cachePath, key)) return false;
+
+        for (auto& entry : cache.meshes()) {
+            std::vector<Tex> textures;
+            for (auto& ref : entry.textures) textures.push_back(loadTexture(ref.path, ref.type));
+            meshes.emplace_back(entry, std::move(textures), residency);
+            if (!meshes.back().Uploaded()) {
+                std::cout << "ERROR::MESH_CACHE::DAMAGED " << cachePath << ", reimporting" << std::endl;
+                cleanup();
+                return false;
+            }
+        }
+        skeleton = cache.animation().skeleton;
+        clips = cache.animation().clips;
+        return true;
+    }
+    static void writeCache(const std::string& cachePath, uint64_t key, const std::vector<PreparedMesh>& prepared,
+                           const std::vector<std::vector<CachedTexture>>& textures, const MeshCacheAnimation& animation) {
+        // The cache holds the GPU streams, so warm loads upload without packing
+        std::vector<MeshCacheInput> inputs;
+        for (size_t i = 0; i < prepared.size(); i++) {
+            const PreparedMesh& mesh = prepared[i];
+            MeshCacheInput input;
+            input.vertices = mesh.stream.data();
+            input.vertexCount = (uint32_t)(mesh.stream.size() / vertexStride(mesh.format));
+            input.vertexFormat = (uint32_t)mesh.format;
+            input.vertexStride = (uint32_t)vertexStride(mesh.format);
+            input.indices = mesh.indexData();
+            input.indexCount = (uint32_t)mesh.indices.size();
+            input.indexSize = (uint32_t)mesh.indexSize();
+            input.textures = textures[i];
+            input.lods = mesh.lods;
+            input.meshlets = mesh.meshlets;
+            input.boundsMin = mesh.boundsMin;
+            input.boundsMax = mesh.boundsMax;
+            input.skinned = mesh.skinned;
+            inputs.push_back(std::move(input));
+        }
+        if (!writeMeshCache(cachePath, key, inputs, animation)) {
+            std::cout << "ERROR::MESH_CACHE::WRITE_FAILED " << cachePath << std::endl;
+        }
+    }
+    // Node order decides draw order before sortForBatching, so keep it
+    static void collectMeshes(const aiNode *node, const aiScene *scene, std::vector<const aiMesh*>& out) {
+        // all the node's meshes (if any)
         for(unsigned int i = 0; i < node->mNumMeshes; i++) {
-            aiMesh *mesh = scene->mMeshes[node->mMeshes[i]]; 
-            meshes.push_back(processMesh(mesh, scene));			
+            out.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
-        // then do the same for each of its children
+        // then the same for each of its children
         for(unsigned int i = 0; i < node->mNumChildren; i++) {
-            processNode(node->mChildren[i], scene);
+            collectMeshes(node->mChildren[i], scene, out);
         }
     }  
     
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene) {
+    // Palette slots go to bones in mesh order, capped at MAX_BONES. Returns
+    // bone name -> slot.
+    std::unordered_map<std::string, int> importSkeleton(const aiScene* scene) {
+        std::unordered_map<std::string, int> bones;
+        auto result = std::make_shared<Skeleton>();
+        for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+            const aiMesh* mesh = scene->mMeshes[m];
+            for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+                std::string name = mesh->mBones[b]->mName.C_Str();
+                if (bones.count(name)) continue;
+                if (bones.size() >= MAX_BONES) {
+                    std::cout << "ERROR::ANIMATION::TOO_MANY_BONES " << name << " dropped, the limit is " << MAX_BONES << std::endl;
+                    continue;
+                }
+                bones.emplace(name, (int)bones.size());
+                result->boneOffsets.push_back(toJointMatrix(toGlm(mesh->mBones[b]->mOffsetMatrix)));
+            }
+        }
+        if (bones.empty()) return bones;
+
+        addJoints(scene->mRootNode, -1, bones, *result);
+        result->globalInverse = toJointMatrix(glm::inverse(toGlm(scene->mRootNode->mTransformation)));
+        skeleton = result;
+        return bones;
+    }
+    static void addJoints(const aiNode* node, int parent, const std::unordered_map<std::string, int>& bones, Skeleton& out) {
+        Joint joint;
+        joint.name = node->mName.C_Str();
+        joint.parent = parent;
+        auto bone = bones.find(joint.name);
+        if (bone != bones.end()) joint.bone = bone->second;
+
+        aiVector3D scaling, position;
+        aiQuaternion rotation;
+        node->mTransformation.Decompose(scaling, rotation, position);
+        joint.bind.translation[0] = position.x; joint.bind.translation[1] = position.y; joint.bind.translation[2] = position.z;
+        joint.bind.rotation[0] = rotation.x; joint.bind.rotation[1] = rotation.y;
+        joint.bind.rotation[2] = rotation.z; joint.bind.rotation[3] = rotation.w;
+        joint.bind.scale[0] = scaling.x; joint.bind.scale[1] = scaling.y; joint.bind.scale[2] = scaling.z;
+
+        int index = (int)out.joints.size();
+        out.joints.push_back(std::move(joint));
+        for (unsigned int i = 0; i < node->mNumChildren; i++) addJoints(node->mChildren[i], index, bones, out);
+    }
+    // Channels become tracks on the skeleton's joints, keys in seconds, and are
+    // compressed right away; the raw tracks only live long enough to be measured against
+    void importAnimations(const aiScene* scene) {
+        if (!skeleton) return;
+        std::unordered_map<std::string, int> joints;
+        for (size_t j = 0; j < skeleton->joints.size(); j++) joints.emplace(skeleton->joints[j].name, (int)j);
+
+        for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+            const aiAnimation* anim = scene->mAnimations[a];
+            double ticks = anim->mTicksPerSecond > 0.0 ? anim->mTicksPerSecond : 25.0;   // Assimp leaves 0 when unknown
+            AnimationClip raw;
+            raw.name = anim->mName.C_Str();
+            raw.duration = (float)(anim->mDuration / ticks);
+
+            for (unsigned int c = 0; c < anim->mNumChannels; c++) {
+                const aiNodeAnim* channel = anim->mChannels[c];
+                auto joint = joints.find(channel->mNodeName.C_Str());
+                if (joint == joints.end()) continue;
+
+                AnimationTrack track;
+                track.joint = joint->second;
+                for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+                    const aiVectorKey& key = channel->mPositionKeys[k];
+                    track.translationTimes.push_back((float)(key.mTime / ticks));
+                    track.translations.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+                    const aiQuatKey& key = channel->mRotationKeys[k];
+                    track.rotationTimes.push_back((float)(key.mTime / ticks));
+                    track.rotations.push_back(glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w));
+                }
+                for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+                    const aiVectorKey& key = channel->mScalingKeys[k];
+                    track.scaleTimes.push_back((float)(key.mTime / ticks));
+                    track.scales.push_back(glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+                }
+                raw.tracks.push_back(std::move(track));
+            }
+            auto compressed = std::make_shared<CompressedClip>(compressClip(*skeleton, raw));
+            compressionTotals.add(measureCompression(*skeleton, raw, *compressed));
+            clips.push_back(std::move(compressed));
+        }
+    }
+    void reportAnimation(const std::string& path) const {
+        if (!skeleton) return;
+        std::cout << "Skeleton for " << path << ": " << skeleton->joints.size() << " joints, "
+                  << skeleton->boneCount() << " bones, " << clips.size() << " clips" << std::endl;
+        // warm loads read the clips already compressed
+        if (clips.empty() || compressionTotals.rawBytes == 0) return;
+        const ClipCompressionStats& c = compressionTotals;
+        std::cout << "Compressed clips for " << path << ": " << c.rawBytes / 1024.0 << " -> "
+                  << c.compressedBytes / 1024.0 << " KB, " << c.rawKeys << " -> " << c.compressedKeys
+                  << " keys, max error " << c.maxError << " (tolerance " << c.tolerance << "), sampling "
+                  << c.rawSampleUs / clips.size() << " -> " << c.compressedSampleUs / clips.size()
+                  << " us per pose" << std::endl;
+    }
+    // Assimp is row-major
+    static glm::mat4 toGlm(const aiMatrix4x4& m) {
+        return glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1),
+                         glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                         glm::vec4(m.a3, m.b3, m.c3, m.d3),
+                         glm::vec4(m.a4, m.b4, m.c4, m.d4));
+    }
+    static JointMatrix toJointMatrix(const glm::mat4& m) {
+        JointMatrix out;
+        std::memcpy(out.m, &m[0][0], sizeof(out.m));
+        return out;
+    }
+    // Keeps the strongest MAX_BONE_INFLUENCE bones of a vertex
+    static void addBoneInfluence(Vertex& vertex, int bone, float weight) {
+        int weakest = 0;
+        for (int i = 1; i < MAX_BONE_INFLUENCE; i++) {
+            if (vertex.m_Weights[i] < vertex.m_Weights[weakest]) weakest = i;
+        }
+        if (weight <= vertex.m_Weights[weakest]) return;
+        vertex.m_BoneIDs[weakest] = bone;
+        vertex.m_Weights[weakest] = weight;
+    }
+
+    // Runs on a pool worker: reads the scene, never touches GL
+    static PreparedMesh processMesh(const aiMesh *mesh, const std::unordered_map<std::string, int>& bones) {
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
-        std::vector<Tex> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve((size_t)mesh->mNumFaces * 3);
 
         for(unsigned int i = 0; i < mesh->mNumVertices; i++) {
-             Vertex vertex;
+            Vertex vertex{};    // zeroed, so unused bone slots are deterministic in the cache
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -100,14 +476,40 @@ private:
             vertices.push_back(vertex);
         }
         // process indices
+        bool triangles = true;
         for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
             aiFace face = mesh->mFaces[i];
+            triangles = triangles && face.mNumIndices == 3;
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);        
         }
-        // process material
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
+        // bone influences, renormalized when some had to be dropped
+        bool skinned = false;
+        for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+            const aiBone* bone = mesh->mBones[b];
+            auto slot = bones.find(bone->mName.C_Str());
+            if (slot == bones.end()) continue;
+            for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+                if (bone->mWeights[w].mVertexId >= vertices.size()) continue;
+                addBoneInfluence(vertices[bone->mWeights[w].mVertexId], slot->second, bone->mWeights[w].mWeight);
+                skinned = true;
+            }
+        }
+        for (auto& v : vertices) {
+            float sum = 0.0f;
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++) sum += v.m_Weights[i];
+            if (sum <= 0.0f) continue;
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++) v.m_Weights[i] /= sum;
+        }
+
+        bool needsTangents = mesh->mTextureCoords[0] && mesh->HasNormals() && !mesh->HasTangentsAndBitangents();
+        PreparedMesh prepared = prepareMesh(std::move(vertices), std::move(indices), triangles, needsTangents);
+        prepared.skinned = skinned;
+        return prepared;
+    }
+    std::vector<Tex> processMaterial(aiMaterial *material) {
+        std::vector<Tex> textures;
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
         // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
         // Same applies to other texture as the following list summarizes:
@@ -127,37 +529,30 @@ private:
         // 4. height maps
         std::vector<Tex> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-        return Mesh(vertices, indices, textures);
+        return textures;
     }  
     std::vector<Tex> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName) {
         std::vector<Tex> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Tex texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     };
+    Tex loadTexture(const std::string& path, const std::string& typeName) {
+        // the cache shares one upload across meshes and models; model textures are decoded flipped
+        // and streamed, so only the mip levels the camera needs stay resident
+        TextureOptions options;
+        options.color = typeName == "texture_diffuse";
+        options.stream = true;
+        Tex texture;
+        texture.handle = TextureCache::get(this->directory + '/' + path, options);
+        texture.id = texture.handle->id;
+        texture.type = typeName;
+        texture.path = path;
+        return texture;
+    }
 
 };
 
@@ -168,32 +563,15 @@ unsigned int TextureFromFile(const char *path, const std::string &directory) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
+    GLState::bindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Baked container if there is one, otherwise decode and build mips on the CPU
+    if (!TextureLoader::loadNow(filename, TextureOptions())) {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
-
     return textureID;
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "shader.hpp"
+#include "uniformBuffer.hpp"
+#include "shaderVariants.hpp"
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 class Object {
 public:
     glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -14,6 +18,21 @@ public:
 
     virtual ~Object() {}
     virtual void update(float dt) = 0;
-    virtual void render(glm::mat4 view, glm::mat4 projection, Shader* defaultShader) = 0;
-    
+    virtual void render(const FrameData& frame, Shader* defaultShader) = 0;
+
+    // Material half of the lit shader variant key
+    virtual ShaderFeatures materialFeatures() const { return ShaderFeatures(); }
+
+    // Vertex format drawn by render(), used to find distinct pipelines
+    virtual uint64_t layoutKey() const { return 0; }
+
+    // Objects returning the same non-zero key under the same shader are
+    // drawn together through renderBatch() on the first of them
+    virtual uint64_t batchKey() const { return 0; }
+    virtual void renderBatch(const FrameData& frame, Shader* shader, const std::vector<Object*>& batch) {}
+
+    // Draws with the texture-streaming feedback shader; objects without
+    // streamed textures draw nothing
+    virtual void renderFeedback(const FrameData& frame, Shader* feedbackShader) {}
+
 };
\ No newline at end of file
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "../object.hpp"
+#include "../modelLoader.hpp"
+#include "../bufferRenderer.hpp"
+#include "../textureCache.hpp"
+#include "../vertexAnimation.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define VAT_POSITION_UNIT 6     // texture units of the baked frames, above any material's
+#define VAT_NORMAL_UNIT 7
+
+// Per-instance data for crowds: model matrix + (clip, seconds of offset)
+struct CrowdInstance {
+    glm::mat4 model;
+    glm::vec2 animation;
+};
+
+// What a crowd keeps per vertex; position and normal are in the baked frames
+struct CrowdVertex {
+    glm::vec2 TexCoords;
+    int32_t vertex;
+};
+
+// Many copies of one animated model, each playing one of its clips from a
+// vertex animation texture baked at load time. No per-instance skinning or
+// palettes: every instance is a transform, a clip and a time offset, and the
+// whole crowd is one instanced draw per material. Instances are relative to
+// the crowd's own transform. Only the full-detail level is drawn.
+class Crowd : public Object {
+public:
+    Crowd(std::string path) : mod((char*)path.c_str(), MeshResidency::Full) {
+        if (!mod.IsAnimated()) {
+            std::cout << "ERROR::CROWD::NOT_ANIMATED " << path << " has no skeleton or clips" << std::endl;
+            return;
+        }
+        bake(path);
+    }
+    // Gives back the heap ranges a crowd that never baked still holds. Scenes
+    // can outlive Renderer::Cleanup, whose glfwTerminate already freed the rest.
+    ~Crowd() {
+        mod.cleanup();
+        if (!TextureCache::hasContext()) return;
+        glDeleteTextures(2, textures);
+        for (GLuint texture : textures) GLState::forgetTexture(texture);
+        buffer.cleanup();
+    }
+    Crowd(const Crowd&) = delete;
+    Crowd& operator=(const Crowd&) = delete;
+
+    size_t clipCount() const { return clips.size(); }
+    size_t size() const { return instances.size(); }
+
+    // Returns the instance's index; clips past the baked ones play the first
+    size_t add(const glm::mat4& transform, size_t clip, float timeOffset = 0.0f) {
+        if (clip >= clips.size()) clip = 0;
+        instances.push_back({transform, glm::vec2((float)clip, timeOffset)});
+        dirty = true;
+        return instances.size() - 1;
+    }
+    void clear() {
+        instances.clear();
+        dirty = true;
+    }
+
+    void update(float dt) override {}
+    uint64_t layoutKey() const override { return buffer.layoutKey(); }
+    ShaderFeatures materialFeatures() const override {
+        ShaderFeatures f;
+        f.specularMap = mod.HasTexture("texture_specular");
+        f.vertexAnimation = true;
+        return f;
+    }
+    void render(const FrameData& frame, Shader* defaultShader) override {
+        draw(shader ? shader : defaultShader);
+    }
+    // The shared feedback program has no baked frames to read, so crowds bring their own variant
+    void renderFeedback(const FrameData& frame, Shader* feedbackShader) override {
+        if (!feedback) {
+            feedback = std::make_unique<Shader>("assets/shaders/feedback.vs", "assets/shaders/feedback.fs",
+                std::vector<ShaderDefine>{{"VERTEX_ANIMATION", "1"}, {"VAT_MAX_CLIPS", std::to_string(VAT_MAX_CLIPS)}});
+            feedbackBias = feedback->uniform<float>("feedbackBias");
+        }
+        feedback->use();
+        feedback->set(feedbackBias, TextureStreamer::feedbackBias());
+        draw(feedback.get());
+    }
+private:
+    ModelLoader mod;
+    BufferRenderer buffer;
+    GLuint textures[2] = {0, 0};            // positions, normals
+    std::vector<VatClip> clips;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsExtent = glm::vec3(0.0f);
+    int rowsPerFrame = 0;
+
+    // Index ranges of `buffer` that share a material, with the mesh to bind it from
+    struct MaterialRun {
+        size_t mesh;
+        size_t firstIndex;
+        size_t count;
+    };
+    std::vector<MaterialRun> runs;
+
+    std::vector<CrowdInstance> instances;
+    std::vector<CrowdInstance> uploaded;    // instances under the crowd's transform
+    glm::mat4 uploadedTransform = glm::mat4(1.0f);
+    bool dirty = true;
+
+    std::unique_ptr<Shader> feedback;
+    UniformHandle<float> feedbackBias;
+
+    glm::mat4 transform() const {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, position);
+        model *= glm::eulerAngleXYZ(
+            glm::radians(rotation.x),
+            glm::radians(rotation.y),
+            glm::radians(rotation.z)
+        );
+        return glm::scale(model, scale);
+    }
+
+    // Concatenates every mesh's vertices and full-detail indices, bakes the
+    // clips over them and uploads the result; the heap geometry and CPU
+    // copies the import kept are released afterwards, only materials stay
+    void bake(const std::string& path) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Mesh>& meshes = mod.Meshes();
+
+        std::vector<Vertex> vertices;
+        std::vector<CrowdVertex> stream;
+        std::vector<uint32_t> indices;
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const Mesh& mesh = meshes[i];
+            uint32_t base = (uint32_t)vertices.size();
+            size_t first = indices.size();
+            for (auto& v : mesh.vertices) {
+                stream.push_back({v.TexCoords, (int32_t)vertices.size()});
+                vertices.push_back(v);
+            }
+            for (unsigned int index : mesh.indices) indices.push_back(base + index);
+
+            if (!runs.empty() && meshes[runs.back().mesh].SameMaterial(mesh)) {
+                runs.back().count += mesh.indices.size();
+            } else {
+                runs.push_back({i, first, mesh.indices.size()});
+            }
+        }
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        uint32_t maxWidth = std::min<uint32_t>(VAT_MAX_WIDTH, (uint32_t)maxSize);
+        VertexAnimationBake baked = bakeVertexAnimation(*mod.GetSkeleton(), mod.Clips(), vertices, maxWidth, (uint32_t)maxSize);
+
+        for (auto& mesh : meshes) {
+            mesh.Release();
+            mesh.ApplyResidency(MeshResidency::None);
+        }
+        if (baked.frames == 0) {
+            std::cout << "ERROR::CROWD::BAKE_FAILED " << path << std::endl;
+            runs.clear();
+            return;
+        }
+
+        clips = baked.clips;
+        boundsMin = baked.boundsMin;
+        boundsExtent = baked.boundsMax - baked.boundsMin;
+        rowsPerFrame = (int)baked.rowsPerFrame;
+
+        glGenTextures(2, textures);
+        uploadTexture(textures[0], GL_RGBA16, GL_UNSIGNED_SHORT, baked.width, baked.height(), baked.positions.data());
+        uploadTexture(textures[1], GL_RGBA8_SNORM, GL_BYTE, baked.width, baked.height(), baked.normals.data());
+
+        buffer.setVertices(stream);
+        buffer.setIndices(indices);
+        buffer.setStride(sizeof(CrowdVertex));
+        buffer.addAttribOffset(0, 1, GL_INT, offsetof(CrowdVertex, vertex));      // int
+        buffer.addAttribOffset(2, 2, GL_FLOAT, offsetof(CrowdVertex, TexCoords));
+        buffer.link();
+
+        buffer.addInstanceAttrib(3, 4, GL_FLOAT, offsetof(CrowdInstance, model));
+        buffer.addInstanceAttrib(4, 4, GL_FLOAT, offsetof(CrowdInstance, model) + sizeof(glm::vec4));
+        buffer.addInstanceAttrib(5, 4, GL_FLOAT, offsetof(CrowdInstance, model) + sizeof(glm::vec4) * 2);
+        buffer.addInstanceAttrib(6, 4, GL_FLOAT, offsetof(CrowdInstance, model) + sizeof(glm::vec4) * 3);
+        buffer.addInstanceAttrib(7, 2, GL_FLOAT, offsetof(CrowdInstance, animation));
+        buffer.linkInstances(sizeof(CrowdInstance));
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Baked vertex animation for " << path << ": " << clips.size() << " clips, " << baked.frames
+                  << " frames of " << baked.vertexCount << " vertices in " << baked.width << "x" << baked.height()
+                  << ", " << baked.bytes() / (1024.0 * 1024.0) << " MB, " << ms << " ms" << std::endl;
+    }
+
+    // Read with texelFetch only: no mips, no filtering
+    static void uploadTexture(GLuint texture, GLint format, GLenum type, uint32_t width, uint32_t height, const void* data) {
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, (GLsizei)width, (GLsizei)height, 0, GL_RGBA, type, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    // Instances go up again only when one was added or the crowd moved
+    void upload() {
+        glm::mat4 crowd = transform();
+        if (!dirty && crowd == uploadedTransform) return;
+        uploaded.resize(instances.size());
+        for (size_t i = 0; i < instances.size(); i++) {
+            uploaded[i] = {crowd * instances[i].model, instances[i].animation};
+        }
+        buffer.setInstances(uploaded);
+        uploadedTransform = crowd;
+        dirty = false;
+    }
+
+    void draw(Shader* useShader) {
+        if (!useShader || runs.empty() || instances.empty()) return;
+        upload();
+
+        useShader->use();
+        if (uniforms.program != useShader->ID) resolveUniforms(*useShader);
+
+        useShader->set(uniforms.diffuse, 0);
+        useShader->set(uniforms.specular, 1);
+        useShader->set(uniforms.shininess, 32.0f);
+        GLState::bindTexture(VAT_POSITION_UNIT, GL_TEXTURE_2D, textures[0]);
+        GLState::bindTexture(VAT_NORMAL_UNIT, GL_TEXTURE_2D, textures[1]);
+        useShader->set(uniforms.positions, VAT_POSITION_UNIT);
+        useShader->set(uniforms.normals, VAT_NORMAL_UNIT);
+        useShader->set(uniforms.boundsMin, boundsMin);
+        useShader->set(uniforms.boundsExtent, boundsExtent);
+        useShader->set(uniforms.rowsPerFrame, rowsPerFrame);
+        for (size_t i = 0; i < clips.size(); i++) {
+            const VatClip& c = clips[i];
+            useShader->set(uniforms.clips[i], glm::vec4((float)c.firstFrame, (float)c.frameCount, c.framesPerSecond, 0.0f));
+        }
+
+        std::vector<Mesh>& meshes = mod.Meshes();
+        for (const MaterialRun& run : runs) {
+            meshes[run.mesh].BindMaterial(*useShader);
+            buffer.drawRangeInstanced(run.count, run.firstIndex, instances.size());
+        }
+    }
+
+    struct {
+        unsigned int program = 0;
+        UniformHandle<int> diffuse;
+        UniformHandle<int> specular;
+        UniformHandle<float> shininess;
+        UniformHandle<int> positions;
+        UniformHandle<int> normals;
+        UniformHandle<glm::vec3> boundsMin;
+        UniformHandle<glm::vec3> boundsExtent;
+        UniformHandle<int> rowsPerFrame;
+        UniformHandle<glm::vec4> clips[VAT_MAX_CLIPS];
+    } uniforms;
+
+    void resolveUniforms(const Shader& s) {
+        uniforms.program = s.ID;
+        uniforms.diffuse = s.uniform<int>("material.diffuse");
+        uniforms.specular = s.uniform<int>("material.specular");
+        uniforms.shininess = s.uniform<float>("material.shininess");
+        uniforms.positions = s.uniform<int>("vatPositions");
+        uniforms.normals = s.uniform<int>("vatNormals");
+        uniforms.boundsMin = s.uniform<glm::vec3>("vatBoundsMin");
+        uniforms.boundsExtent = s.uniform<glm::vec3>("vatBoundsExtent");
+        uniforms.rowsPerFrame = s.uniform<int>("vatRowsPerFrame");
+        for (int i = 0; i < VAT_MAX_CLIPS; i++) {
+            uniforms.clips[i] = s.uniform<glm::vec4>("vatClips[" + std::to_string(i) + "]");
+        }
+    }
+};
@@ -4,18 +4,31 @@
 
 #include "../shader.hpp"
 #include "../bufferRenderer.hpp"
+#include "../textureArray.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <vector>
+
+// Per-instance data for batched cubes: model matrix + (diffuse, specular) layers
+struct CubeInstance {
+    glm::mat4 model;
+    glm::ivec2 layers;
+};
 
 class Cube : public Object {
 public:
     Texture diffuse;
     Texture specular;
 
+    // When set, the cube samples these array slices instead of `diffuse` /
+    // `specular` and is drawn instanced with every cube sharing its arrays
+    TextureLayerHandle diffuseLayer;
+    TextureLayerHandle specularLayer;
+
     Cube() {
         cube.setVertices(vertices, sizeof(vertices)/sizeof(float));
 
@@ -23,6 +36,13 @@ public:
         cube.addAttrib(1, 3, GL_FLOAT); // normals
         cube.addAttrib(2, 2, GL_FLOAT); // texcoords
         cube.link();
+
+        cube.addInstanceAttrib(3, 4, GL_FLOAT, offsetof(CubeInstance, model));
+        cube.addInstanceAttrib(4, 4, GL_FLOAT, offsetof(CubeInstance, model) + sizeof(glm::vec4));
+        cube.addInstanceAttrib(5, 4, GL_FLOAT, offsetof(CubeInstance, model) + sizeof(glm::vec4) * 2);
+        cube.addInstanceAttrib(6, 4, GL_FLOAT, offsetof(CubeInstance, model) + sizeof(glm::vec4) * 3);
+        cube.addInstanceAttrib(7, 2, GL_INT, offsetof(CubeInstance, layers));
+        cube.linkInstances(sizeof(CubeInstance));
     };
     float vertices[288] = {
         // positions          // normals           // texture coords
@@ -69,28 +89,89 @@ public:
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
     };
     void update(float dt) override {}
-    void render(glm::mat4 view, glm::mat4 projection, Shader* defaultShader) override {
+    uint64_t layoutKey() const override { return cube.layoutKey(); }
+    ShaderFeatures materialFeatures() const override {
+        ShaderFeatures f;
+        f.specularMap = specular.texture != 0 || specularLayer;
+        f.textureArrays = usesLayers();
+        return f;
+    }
+    uint64_t batchKey() const override {
+        if (!usesLayers()) return 0;
+        uint64_t key = cube.layoutKey();
+        key = key * 31 + diffuseLayer->array;
+        key = key * 31 + (specularLayer ? specularLayer->array : 0);
+        return key;
+    }
+    void render(const FrameData& frame, Shader* defaultShader) override {
         Shader* useShader = shader ? shader : defaultShader;
         if (!useShader) return;
+
+        if (usesLayers()) {
+            renderBatch(frame, useShader, {this});
+            return;
+        }
         
         useShader->use();
-        diffuse.bind(0, "material.diffuse");
-        specular.bind(1, "material.specular");
-        useShader->setFloat("material.shininess", 32.0f);
-        useShader->setMat4("projection", projection);
-        useShader->setMat4("view", view);
+        if (uniforms.program != useShader->ID) resolveUniforms(*useShader);
+
+        diffuse.bind(0, uniforms.diffuse);
+        specular.bind(1, uniforms.specular);
+        useShader->set(uniforms.shininess, 32.0f);
+        useShader->set(uniforms.model, modelMatrix());
+        cube.draw();
+    }
+
+    // Every cube in `batch` shares this cube's vertex layout and arrays
+    void renderBatch(const FrameData& frame, Shader* useShader, const std::vector<Object*>& batch) override {
+        useShader->use();
+        if (uniforms.program != useShader->ID) resolveUniforms(*useShader);
+
+        GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, diffuseLayer->array);
+        GLState::bindTexture(1, GL_TEXTURE_2D_ARRAY, specularLayer ? specularLayer->array : 0);
+        useShader->set(uniforms.diffuse, 0);
+        useShader->set(uniforms.specular, 1);
+        useShader->set(uniforms.shininess, 32.0f);
+
+        instances.clear();
+        for (Object* obj : batch) {
+            Cube* c = static_cast<Cube*>(obj);
+            instances.push_back({c->modelMatrix(), glm::ivec2(c->diffuseLayer->layer, c->specularLayer ? c->specularLayer->layer : 0)});
+        }
+        cube.setInstances(instances);
+        cube.drawInstanced(instances.size());
+    }
+private:
+    BufferRenderer cube;
+    std::vector<CubeInstance> instances;
+
+    bool usesLayers() const { return diffuseLayer != nullptr; }
+
+    glm::mat4 modelMatrix() const {
         glm::mat4 model = glm::mat4(1.0f);
-        model = glm::mat4(1.0f);
         model = glm::translate(model, position);
         model *= glm::eulerAngleXYZ(
             glm::radians(rotation.x),
             glm::radians(rotation.y),
             glm::radians(rotation.z)
         );
-        model = glm::scale(model, scale); 
-        useShader->setMat4("model", model);
-        cube.draw();
+        return glm::scale(model, scale);
+    }
+
+    // Handles are resolved per program, so re-resolve if the shader changes
+    struct {
+        unsigned int program = 0;
+        UniformHandle<int> diffuse;
+        UniformHandle<int> specular;
+        UniformHandle<float> shininess;
+        UniformHandle<glm::mat4> model;
+    } uniforms;
+
+    void resolveUniforms(const Shader& s) {
+        uniforms.program = s.ID;
+        uniforms.diffuse = s.uniform<int>("material.diffuse");
+        uniforms.specular = s.uniform<int>("material.specular");
+        uniforms.shininess = s.uniform<float>("material.shininess");
+        uniforms.model = s.uniform<glm::mat4>("model");
     }
-private:
-    BufferRenderer cube;
 };
\ No newline at end of file
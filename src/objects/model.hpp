@@ -2,38 +2,126 @@
 
 #include "../object.hpp"
 #include "../modelLoader.hpp"
+#include "../animationSystem.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
 
 class Model : public Object {
 public:
-    Model(std::string path) : mod((char*)path.c_str()) {};
+    // Meshlets whose faces all point away are skipped; turn off for double-sided models
+    bool cullBackfaces = true;
+
+    // Animated models start playing their first clip
+    Model(std::string path, MeshResidency residency = MeshResidency::None) : mod((char*)path.c_str(), residency) {
+        if (mod.IsAnimated()) animation = AnimationSystem::create(mod.GetSkeleton(), mod.Clips());
+    };
+    // Gives the meshes' heap ranges back; safe since a Model is never copied
+    ~Model() {
+        AnimationSystem::release(animation);
+        mod.cleanup();
+    }
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    size_t clipCount() const { return mod.Clips().size(); }
+    void playAnimation(size_t clip, float fade = ANIMATION_FADE_SECONDS) { AnimationSystem::play(animation, clip, fade); }
+    void setAnimationSpeed(float speed) { AnimationSystem::setSpeed(animation, speed); }
+    void setAnimationTime(float seconds) { AnimationSystem::setTime(animation, seconds); }
 
     void update(float dt) override {}
-    void render(glm::mat4 view, glm::mat4 projection, Shader* defaultShader) override {
-        Shader* useShader = shader ? shader : defaultShader;
-        if (!useShader) return;
+    uint64_t layoutKey() const override { return mod.LayoutKey(); }
+    ShaderFeatures materialFeatures() const override {
+        ShaderFeatures f;
+        f.specularMap = mod.HasTexture("texture_specular");
+        f.skinned = animation != 0;
+        return f;
+    }
+    void render(const FrameData& frame, Shader* defaultShader) override {
+        selectLods(frame);
+        mod.CullMeshlets(meshletView(frame.viewProjection, transform(), glm::vec3(frame.cameraPos), cullBackfaces));
+        draw(shader ? shader : defaultShader);
+    }
+    // Animated models request mips for the skinned pose, through a SKINNED
+    // feedback variant shared by all of them
+    void renderFeedback(const FrameData& frame, Shader* feedbackShader) override {
+        if (!animation) {
+            draw(feedbackShader);
+            return;
+        }
+        if (!skinnedFeedback) {
+            skinnedFeedback = std::make_unique<Shader>("assets/shaders/feedback.vs", "assets/shaders/feedback.fs",
+                std::vector<ShaderDefine>{{"SKINNED", "1"}, {"MAX_BONES", std::to_string(MAX_BONES)}});
+            skinnedFeedbackBias = skinnedFeedback->uniform<float>("feedbackBias");
+        }
+        skinnedFeedback->use();
+        skinnedFeedback->set(skinnedFeedbackBias, TextureStreamer::feedbackBias());
+        draw(skinnedFeedback.get());
+    }
+private:
+    ModelLoader mod;
+    AnimationHandle animation = 0;
 
-        useShader->use();
-        useShader->setFloat("material.shininess", 32.0f);
-        useShader->setMat4("projection", projection);
-        useShader->setMat4("view", view);
+    inline static std::unique_ptr<Shader> skinnedFeedback;
+    inline static UniformHandle<float> skinnedFeedbackBias;
+
+    glm::mat4 transform() const {
         glm::mat4 model = glm::mat4(1.0f);
-        model = glm::mat4(1.0f);
         model = glm::translate(model, position);
         model *= glm::eulerAngleXYZ(
             glm::radians(rotation.x),
             glm::radians(rotation.y),
             glm::radians(rotation.z)
         );
-        model = glm::scale(model, scale); 
-        useShader->setMat4("model", model);
+        return glm::scale(model, scale);
+    }
+
+    // Screen coverage of one object-space unit at the nearest point of the
+    // bounding sphere, which is what a LOD's error is scaled by
+    void selectLods(const FrameData& frame) {
+        float maxScale = std::max(std::fabs(scale.x), std::max(std::fabs(scale.y), std::fabs(scale.z)));
+        glm::vec3 center = glm::vec3(transform() * glm::vec4(mod.BoundsCenter(), 1.0f));
+        float distance = glm::length(center - glm::vec3(frame.cameraPos)) - mod.BoundsRadius() * maxScale;
+        distance = std::max(distance, 0.001f);
+        mod.SelectLods(maxScale * frame.projection[1][1] * 0.5f / distance);
+    }
+
+    void draw(Shader* useShader) {
+        if (!useShader) return;
+
+        useShader->use();
+        if (uniforms.program != useShader->ID) resolveUniforms(*useShader);
+
+        useShader->set(uniforms.diffuse, 0);
+        useShader->set(uniforms.specular, 1);
+        useShader->set(uniforms.shininess, 32.0f);
+        useShader->set(uniforms.model, transform());
+        if (animation) AnimationSystem::bind(animation);
         mod.Draw(*useShader);
     }
-private:
-    ModelLoader mod;
+
+    struct {
+        unsigned int program = 0;
+        UniformHandle<int> diffuse;
+        UniformHandle<int> specular;
+        UniformHandle<float> shininess;
+        UniformHandle<glm::mat4> model;
+    } uniforms;
+
+    void resolveUniforms(const Shader& s) {
+        uniforms.program = s.ID;
+        uniforms.diffuse = s.uniform<int>("material.diffuse");
+        uniforms.specular = s.uniform<int>("material.specular");
+        uniforms.shininess = s.uniform<float>("material.shininess");
+        uniforms.model = s.uniform<glm::mat4>("model");
+    }
 };
\ No newline at end of file
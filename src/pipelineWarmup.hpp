@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "glState.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <unordered_set>
+
+// Many drivers only finish compiling (and patch shaders for the bound
+// vertex format and render target) on the first draw that uses a given
+// combination. This issues those first draws into 1x1 targets during
+// loading so they don't land inside the first frames.
+class PipelineWarmup {
+public:
+    // Formats of the targets the real frame renders to
+    enum Target {
+        SCENE_TARGET = 0,    // Framebuffer: RGB8 color + D24S8
+        SCREEN_TARGET = 1,   // backbuffer: RGBA8, no depth
+        TARGET_COUNT
+    };
+
+    PipelineWarmup() {
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        start = std::chrono::steady_clock::now();
+    }
+
+    // Runs draw() with the 1x1 stand-in for target bound. Draws issued
+    // inside only cost a single pixel of fill.
+    void draw(Target target, const std::function<void()>& drawFn) {
+        bindTarget(target);
+        drawFn();
+        draws++;
+    }
+
+    // Blocks until the driver has consumed every warm-up draw, then drops
+    // the throwaway targets and restores the window viewport
+    void finish() {
+        glFinish();
+        GLState::bindFramebuffer(0);
+        glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+        for (int i = 0; i < TARGET_COUNT; i++) {
+            if (framebuffers[i] == 0) continue;
+            glDeleteFramebuffers(1, &framebuffers[i]);
+            glDeleteTextures(1, &colors[i]);
+            GLState::forgetFramebuffer(framebuffers[i]);
+            GLState::forgetTexture(colors[i]);
+            if (depths[i]) glDeleteRenderbuffers(1, &depths[i]);
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Pipeline warm-up: " << draws << " passes in " << elapsed.count() << " ms" << std::endl;
+    }
+
+private:
+    GLuint framebuffers[TARGET_COUNT] = {0, 0};
+    GLuint colors[TARGET_COUNT] = {0, 0};
+    GLuint depths[TARGET_COUNT] = {0, 0};
+    GLint savedViewport[4] = {0, 0, 0, 0};
+    unsigned int draws = 0;
+    std::chrono::steady_clock::time_point start;
+
+    void bindTarget(Target target) {
+        if (framebuffers[target] == 0) createTarget(target);
+        GLState::bindFramebuffer(framebuffers[target]);
+        glViewport(0, 0, 1, 1);
+    }
+
+    void createTarget(Target target) {
+        glGenFramebuffers(1, &framebuffers[target]);
+        GLState::bindFramebuffer(framebuffers[target]);
+
+        GLenum format = target == SCENE_TARGET ? GL_RGB : GL_RGBA;
+        glGenTextures(1, &colors[target]);
+        GLState::bindTexture(GL_TEXTURE_2D, colors[target]);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, 1, 1, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colors[target], 0);
+
+        if (target == SCENE_TARGET) {
+            glGenRenderbuffers(1, &depths[target]);
+            glBindRenderbuffer(GL_RENDERBUFFER, depths[target]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1, 1);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depths[target]);
+        }
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::WARMUP:: 1x1 target is not complete!\n";
+    }
+};
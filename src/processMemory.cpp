@@ -0,0 +1,69 @@
+#include "processMemory.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <cstdio>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+
+namespace {
+    PROCESS_MEMORY_COUNTERS counters() {
+        PROCESS_MEMORY_COUNTERS c{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &c, sizeof(c));
+        return c;
+    }
+}
+
+size_t currentResidentBytes() { return counters().WorkingSetSize; }
+size_t peakResidentBytes() { return counters().PeakWorkingSetSize; }
+
+#elif defined(__APPLE__)
+
+size_t currentResidentBytes() {
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+    return info.resident_size;
+}
+
+size_t peakResidentBytes() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (size_t)usage.ru_maxrss;     // bytes on macOS
+}
+
+#else
+
+namespace {
+    // "VmRSS:     123456 kB" style fields of /proc/self/status
+    size_t statusField(const char* name) {
+        FILE* file = std::fopen("/proc/self/status", "r");
+        if (!file) return 0;
+
+        char line[256];
+        size_t kilobytes = 0;
+        size_t length = std::strlen(name);
+        while (std::fgets(line, sizeof(line), file)) {
+            if (std::strncmp(line, name, length) == 0 && line[length] == ':') {
+                std::sscanf(line + length + 1, "%zu", &kilobytes);
+                break;
+            }
+        }
+        std::fclose(file);
+        return kilobytes * 1024;
+    }
+}
+
+size_t currentResidentBytes() { return statusField("VmRSS"); }
+size_t peakResidentBytes() { return statusField("VmHWM"); }
+
+#endif
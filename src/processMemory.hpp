@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Resident set size of this process in bytes: now, and the high-water mark
+// since start. 0 where the platform does not report it.
+size_t currentResidentBytes();
+size_t peakResidentBytes();
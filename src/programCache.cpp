@@ -0,0 +1,136 @@
+#include "programCache.hpp"
+#include "glExtensions.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+namespace {
+    const uint32_t CACHE_MAGIC = 0x42505347; // "GSPB"
+    const uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+const std::string& ProgramCache::driverId() {
+    static std::string id;
+    if (id.empty()) {
+        auto str = [](GLenum name) {
+            const char* s = (const char*)glGetString(name);
+            return std::string(s ? s : "");
+        };
+        id = str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+    }
+    return id;
+}
+
+uint64_t ProgramCache::key(const std::string& vertexCode, const std::string& fragmentCode) {
+    uint64_t hash = fnv1a(vertexCode);
+    hash = fnv1a(std::string(1, '\0') + fragmentCode, hash);
+    return fnv1a(std::string(1, '\0') + driverId(), hash);
+}
+
+std::string ProgramCache::path(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return directory + "/" + name;
+}
+
+void ProgramCache::prepare(GLuint program) {
+    if (!GLExtensions::programBinary) return;
+    GLExtensions::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+GLuint ProgramCache::load(uint64_t key) {
+    if (!GLExtensions::programBinary) {
+        stats.misses++;
+        return 0;
+    }
+
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file) {
+        stats.misses++;
+        return 0;
+    }
+
+    CacheHeader header{};
+    file.read((char*)&header, sizeof(header));
+    std::vector<char> binary;
+    if (file && header.magic == CACHE_MAGIC && header.version == CACHE_VERSION) {
+        binary.resize(header.length);
+        file.read(binary.data(), header.length);
+    }
+
+    if (!file || binary.empty()) {
+        stats.rejected++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    GLExtensions::ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Driver refused the blob (e.g. it was updated); drop it and compile normally
+        glDeleteProgram(program);
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(path(key), ec);
+        stats.rejected++;
+        return 0;
+    }
+
+    stats.hits++;
+    return program;
+}
+
+void ProgramCache::store(GLuint program, uint64_t key) {
+    if (!GLExtensions::programBinary) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLExtensions::GetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, format, (uint32_t)written};
+    std::ofstream file(path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "WARNING: Could not write program cache to " << directory << std::endl;
+        return;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), written);
+}
+
+void ProgramCache::report() {
+    const char* start = stats.hits > 0 && stats.misses == 0 && stats.rejected == 0 ? "warm" : "cold";
+    std::cout << "Shader programs: " << (stats.hits + stats.misses + stats.rejected)
+              << " (" << stats.hits << " cached, " << stats.misses << " compiled, "
+              << stats.rejected << " rejected) in " << stats.milliseconds << " ms, "
+              << start << " start" << (GLExtensions::programBinary ? "" : " [program binaries unsupported]")
+              << std::endl;
+}
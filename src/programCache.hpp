@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+struct ProgramCacheStats {
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    unsigned int rejected = 0;
+    double milliseconds = 0.0;
+};
+
+// On-disk cache of linked program binaries (ARB_get_program_binary).
+// Entries are keyed by the preprocessed sources plus the driver identity,
+// so a driver update or shader edit simply misses and recompiles.
+class ProgramCache {
+public:
+    inline static std::string directory = "cache/shaders";
+
+    static uint64_t key(const std::string& vertexCode, const std::string& fragmentCode);
+
+    // Returns a linked program, or 0 when there is no usable entry
+    static GLuint load(uint64_t key);
+    static void store(GLuint program, uint64_t key);
+
+    // Call before glLinkProgram so the driver keeps a retrievable binary
+    static void prepare(GLuint program);
+
+    static void recordTime(double ms) { stats.milliseconds += ms; }
+    static const ProgramCacheStats& GetStats() { return stats; }
+    static void report();
+
+private:
+    inline static ProgramCacheStats stats;
+
+    static std::string path(uint64_t key);
+    static const std::string& driverId();
+};
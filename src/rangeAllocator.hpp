@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+// First-fit free list over [0, capacity) in caller-chosen units. Freed
+// ranges merge with their neighbours, so a fully freed allocator is one
+// hole again.
+class RangeAllocator {
+public:
+    explicit RangeAllocator(size_t capacity = 0) { grow(capacity); }
+
+    bool allocate(size_t size, size_t& offset) {
+        if (size == 0) {
+            offset = 0;
+            return true;
+        }
+        for (auto it = holes.begin(); it != holes.end(); ++it) {
+            if (it->second < size) continue;
+            offset = it->first;
+            size_t rest = it->second - size;
+            holes.erase(it);
+            if (rest) holes[offset + size] = rest;
+            used += size;
+            return true;
+        }
+        return false;
+    }
+
+    void free(size_t offset, size_t size) {
+        if (size == 0) return;
+        used -= size;
+
+        auto next = holes.lower_bound(offset);
+        if (next != holes.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                holes.erase(prev);
+            }
+        }
+        if (next != holes.end() && offset + size == next->first) {
+            size += next->second;
+            holes.erase(next);
+        }
+        holes[offset] = size;
+    }
+
+    // Adds [capacity, newCapacity) as free space
+    void grow(size_t newCapacity) {
+        if (newCapacity <= total) return;
+        size_t added = newCapacity - total;
+        size_t offset = total;
+        total = newCapacity;
+        used += added;      // free() takes it back out
+        free(offset, added);
+    }
+
+    // After the caller packed every live range to the front
+    void reset(size_t packed) {
+        holes.clear();
+        used = packed;
+        if (packed < total) holes[packed] = total - packed;
+    }
+
+    size_t capacity() const { return total; }
+    size_t allocated() const { return used; }
+    size_t available() const { return total - used; }
+    size_t holeCount() const { return holes.size(); }
+
+private:
+    std::map<size_t, size_t> holes;     // offset -> size
+    size_t total = 0;
+    size_t used = 0;
+};
@@ -11,9 +11,20 @@
 #include "./IO/input.hpp"
 #include "shader.hpp"
 #include "framebuffer.hpp"
+#include "glExtensions.hpp"
+#include "glState.hpp"
+#include "frameTimeLog.hpp"
+#include "textureLoader.hpp"
+#include "textureCache.hpp"
+#include "textureArray.hpp"
+#include "textureStreamer.hpp"
+#include "geometryHeap.hpp"
+#include "meshlet.hpp"
+#include "animationSystem.hpp"
 
 #include <string>
 #include <functional>
+#include <unordered_set>
 #include <iostream>
 
 class Renderer {
@@ -58,8 +69,9 @@ public:
         if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
             std::cout << "Failed to initialize GLAD" << std::endl;
         }
+        GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
-        glEnable(GL_DEPTH_TEST);
+        GLState::enable(GL_DEPTH_TEST);
         
 
         // Framebuffer resize callback
@@ -93,6 +105,17 @@ public:
         if (glfwWindowShouldClose(window)) return false;
 
         deltaTime = CalculateDeltaTime();
+        // The first call only measures time since start-up
+        if (frameCount++ > 0) frameLog.record(deltaTime);
+        Shader::beginFrame();
+        GLState::beginFrame();
+        GeometryHeap::beginFrame();
+        MeshletCulling::beginFrame();
+
+        TextureLoader::pump();
+        TextureArrays::pump();
+        TextureStreamer::update(deltaTime);
+        AnimationSystem::update(deltaTime);
 
         input->update();
         if (inputCallback) inputCallback(window);
@@ -110,6 +133,7 @@ public:
     void RenderLast() {
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        GLState::invalidate(); // ImGui binds its own program, VAO and textures
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
@@ -126,11 +150,18 @@ public:
     Input* GetInput() { return input; }
     GLFWwindow* GetWindow() { return window; }
     float GetDeltaTime() { return deltaTime; }
+    const FrameTimeLog& GetFrameLog() { return frameLog; }
 
     bool getImGuiWantCaptureMouse() { return ImGui::GetIO().WantCaptureMouse; }
     bool getImGuiWantCaptureKeyboard() { return ImGui::GetIO().WantCaptureKeyboard; }
 
     void Cleanup() {
+        TextureLoader::cleanup();
+        TextureArrays::cleanup();
+        TextureStreamer::cleanup();
+        GeometryHeap::cleanup();
+        AnimationSystem::cleanup();
+
         delete input;
         input = nullptr;
 
@@ -138,6 +169,7 @@ public:
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
+        TextureCache::shutdown();
         glfwTerminate();
     }
 
@@ -147,6 +179,8 @@ private:
 
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
+    unsigned int frameCount = 0;
+    FrameTimeLog frameLog{120};
 
     glm::vec3 clearColor;
     unsigned int clearBuffers;
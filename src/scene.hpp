@@ -1,11 +1,16 @@
 #pragma once
 
 #include <iostream>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <string>
 
 #include "object.hpp"
+#include "uniformBuffer.hpp"
+#include "lights.hpp"
+#include "shaderVariants.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,8 +21,18 @@ class Scene {
 public:
     glm::mat4 view;
     glm::mat4 projection;
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    float time = 0.0f;
+    float deltaTime = 0.0f;
+    Lights lights;
 
-    Scene() {}
+    Scene()
+        : frameUniforms(FRAME_DATA_BINDING, sizeof(FrameData)),
+          lightUniforms(LIGHT_DATA_BINDING, sizeof(LightData)) {}
+
+    // Objects without their own shader get the smallest variant of this
+    // that covers the scene lights and their material
+    void SetLitShader(ShaderVariants* variants) { litShader = variants; }
 
     void addObject(const std::string& name, std::unique_ptr<Object> obj) {
         objects[name] = std::move(obj);
@@ -35,20 +50,91 @@ public:
 
     void render() {
         Shader* defaultShader = Shader::getCurrentShader();
+        uploadFrame();
+
+        // Batchable objects are grouped by (batch key, program) and drawn once per group
+        std::map<std::pair<uint64_t, Shader*>, std::vector<Object*>> batches;
+        for (auto& [name, obj] : objects) {
+            Shader* useShader = shaderFor(*obj, defaultShader);
+            uint64_t key = obj->batchKey();
+            if (key != 0 && useShader) {
+                batches[{key, useShader}].push_back(obj.get());
+            } else {
+                obj->render(frame, useShader);
+            }
+        }
+        for (auto& [key, batch] : batches) {
+            batch.front()->renderBatch(frame, key.second, batch);
+        }
+    }
 
+    // Texture-streaming feedback pass; the target is bound by TextureStreamer
+    void renderFeedback(Shader* feedbackShader) {
+        uploadFrame();
         for (auto& [name, obj] : objects) {
-            obj->render(view, projection, defaultShader);
+            obj->renderFeedback(frame, feedbackShader);
         }
     }
+
+    // Draws one object per distinct (program, vertex layout) pair. Used by
+    // PipelineWarmup so drivers finish deferred compiles before the first frame.
+    unsigned int renderUniquePipelines() {
+        Shader* defaultShader = Shader::getCurrentShader();
+        uploadFrame();
+
+        std::unordered_set<uint64_t> seen;
+        for (auto& [name, obj] : objects) {
+            Shader* useShader = shaderFor(*obj, defaultShader);
+            if (!useShader) continue;
+            uint64_t key = obj->layoutKey() * 31 + useShader->ID;
+            if (seen.insert(key).second) {
+                obj->render(frame, useShader);
+            }
+        }
+        return (unsigned int)seen.size();
+    }
     template <typename T, typename... Args>
     static std::unique_ptr<T> NewInstance(Args&&... args) {
         return std::make_unique<T>(std::forward<Args>(args)...);
     }
 
+    // Lit variants the current objects and lights will ask for
+    std::vector<ShaderFeatures> LitFeatures() const {
+        std::vector<ShaderFeatures> features;
+        ShaderFeatures sceneFeatures = lights.features();
+        for (auto& [name, obj] : objects) {
+            if (!obj->shader) features.push_back(sceneFeatures | obj->materialFeatures());
+        }
+        return features;
+    }
+
     Object* getObject(const std::string& name) {
         auto it = objects.find(name);
         return it != objects.end() ? it->second.get() : nullptr;
     }
+    const FrameData& Frame() const { return frame; }
 private:
     std::unordered_map<std::string, std::unique_ptr<Object>> objects;
+
+    void uploadFrame() {
+        // One upload per frame, shared by every program through FRAME_DATA_BINDING
+        frame.view = view;
+        frame.projection = projection;
+        frame.viewProjection = projection * view;
+        frame.cameraPos = glm::vec4(cameraPos, 1.0f);
+        frame.time = glm::vec4(time, deltaTime, 0.0f, 0.0f);
+        frameUniforms.update(frame);
+        lightUniforms.update(lights.Data());
+    }
+
+    Shader* shaderFor(Object& obj, Shader* defaultShader) {
+        if (obj.shader) return obj.shader;
+        if (litShader) return litShader->get(lights.features() | obj.materialFeatures());
+        return defaultShader;
+    }
+
+    FrameData frame;
+    UniformBuffer frameUniforms;
+    UniformBuffer lightUniforms;
+    ShaderVariants* litShader = nullptr;
 };
\ No newline at end of file
@@ -1,93 +1,224 @@
 #include "shader.hpp"
+#include "uniformBuffer.hpp"
+#include "programCache.hpp"
+#include "glExtensions.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 std::vector<unsigned int> Shader::allShaders;
 Shader* Shader::currentShader = nullptr;
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    // 1. Get File Data
-    std::string vertexCode;
-    std::string fragmentCode;
+Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : Shader(vertexPath, fragmentPath, {}) {}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<ShaderDefine>& defines) {
+    auto start = std::chrono::steady_clock::now();
+
+    submit(loadSources(vertexPath, fragmentPath, defines));
+    finish();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    ProgramCache::recordTime(elapsed.count());
+}
 
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+Shader::Shader(const ShaderSources& sources) {
+    submit(sources);
+}
 
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+ShaderSources Shader::loadSources(const std::string &vertexPath, const std::string &fragmentPath, const std::vector<ShaderDefine>& defines) {
+    // 1. Get File Data
+    ShaderSources sources;
 
     try {
-        // Open Files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        
-        // Put Buffers into Stream
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-
-        // Close Files
-        vShaderFile.close();
-        fShaderFile.close();
-
-        // Retrive Code
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch(std::ifstream::failure err) {
+        sources.vertex = readSource(vertexPath);
+        sources.fragment = readSource(fragmentPath);
+    } catch(const std::ifstream::failure& err) {
         std::cout << "ERROR: Shader file read fail!" << std::endl;
     }
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    // 2. Compile Shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+    if (!defines.empty()) {
+        sources.vertex = injectDefines(sources.vertex, defines);
+        sources.fragment = injectDefines(sources.fragment, defines);
+    }
+    return sources;
+}
 
-    // Vertex Shader Compilation
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
+void Shader::submit(const ShaderSources& sources) {
+    // Reuse a cached program binary when the driver accepts it
+    cacheKey = ProgramCache::key(sources.vertex, sources.fragment);
+    ID = ProgramCache::load(cacheKey);
+    if (ID != 0) return;
 
-    // Error Handling
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR: Vertex Shader compilation error!\n" << infoLog << std::endl;
-    }
+    const char* vShaderCode = sources.vertex.c_str();
+    const char* fShaderCode = sources.fragment.c_str();
 
-    // Fragment Shader Compilation
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
+    // 2. Compile Shaders. No status queries here: they would block on the
+    // driver compiler before the rest of the batch has been submitted.
+    pendingVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pendingVertex, 1, &vShaderCode, NULL);
+    glCompileShader(pendingVertex);
 
-    // Error Handling
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR: Vertex Shader compilation error!\n" << infoLog << std::endl;
-    }
+    pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pendingFragment, 1, &fShaderCode, NULL);
+    glCompileShader(pendingFragment);
 
     // Create Shader Program
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glAttachShader(ID, pendingVertex);
+    glAttachShader(ID, pendingFragment);
+    ProgramCache::prepare(ID);
     glLinkProgram(ID);
+}
+
+bool Shader::isReady() const {
+    if (finished || pendingVertex == 0 || !GLExtensions::parallelShaderCompile) return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
 
-    // Error Handling
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cout << "ERROR: Shader program linking error!\n" << infoLog << std::endl;
+bool Shader::finish() {
+    if (finished) return ID != 0;
+    finished = true;
+
+    int success = 1;
+    if (pendingVertex != 0) {
+        char infoLog[512];
+
+        // Error Handling
+        glGetShaderiv(pendingVertex, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(pendingVertex, 512, NULL, infoLog);
+            std::cout << "ERROR: Vertex Shader compilation error!\n" << infoLog << std::endl;
+        }
+
+        glGetShaderiv(pendingFragment, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(pendingFragment, 512, NULL, infoLog);
+            std::cout << "ERROR: Fragment Shader compilation error!\n" << infoLog << std::endl;
+        }
+
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(ID, 512, NULL, infoLog);
+            std::cout << "ERROR: Shader program linking error!\n" << infoLog << std::endl;
+        }
+
+        // Delete Shaders
+        glDeleteShader(pendingVertex);
+        glDeleteShader(pendingFragment);
+        pendingVertex = 0;
+        pendingFragment = 0;
+
+        if (success) {
+            ProgramCache::store(ID, cacheKey);
+        }
     }
 
-    // Delete Shaders
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    buildUniformTable();
+    bindUniformBlocks();
 
     allShaders.push_back(ID);
+    return success;
+}
+
+std::string Shader::readSource(const std::string &path, int depth) {
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    file.open(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    file.close();
+
+    // Resolve #include "file" relative to the including shader
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    std::string source;
+    std::string line;
+    while (std::getline(stream, line)) {
+        size_t pos = line.find("#include");
+        size_t open = line.find('"');
+        size_t close = line.rfind('"');
+        if (pos != std::string::npos && open != std::string::npos && close > open && depth < 8) {
+            source += readSource(directory + line.substr(open + 1, close - open - 1), depth + 1);
+        } else {
+            source += line;
+            source += '\n';
+        }
+    }
+    return source;
+}
+
+std::string Shader::injectDefines(const std::string &source, const std::vector<ShaderDefine>& defines) {
+    std::string block;
+    for (auto& define : defines) {
+        block += "#define " + define.name + " " + define.value + "\n";
+    }
+
+    // #version has to stay the first directive
+    size_t version = source.find("#version");
+    if (version == std::string::npos) return block + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos) return source + "\n" + block;
+    return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
+}
+
+void Shader::bindUniformBlocks() {
+    for (auto& [name, binding] : uniformBlockBindings) {
+        GLuint index = glGetUniformBlockIndex(ID, name);
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, index, binding);
+        }
+    }
+}
+
+void Shader::buildUniformTable() {
+    // List every active uniform once at link time so lookups never hit the driver
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> nameBuffer(std::max(maxLength, 1));
+    uniforms.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), length);
+        GLint loc = glGetUniformLocation(ID, name.c_str());
+        if (loc < 0) continue; // uniform block members have no location
+
+        uniforms[name] = {loc, type, size};
+
+        // Arrays of basic types are reported once as "name[0]"; register every element
+        size_t bracket = name.rfind("[0]");
+        if (bracket != std::string::npos && bracket + 3 == name.size()) {
+            std::string base = name.substr(0, bracket);
+            uniforms[base] = {loc, type, size};
+            for (int e = 1; e < size; e++) {
+                std::string element = base + "[" + std::to_string(e) + "]";
+                uniforms[element] = {glGetUniformLocation(ID, element.c_str()), type, 1};
+            }
+        }
+    }
+}
+
+void Shader::checkType(const std::string &name, GLenum actual, GLenum expected) const {
+    if (actual == expected || expected == GL_NONE) return;
+
+    // Samplers and bools are set through the integer path
+    bool intLike = actual == GL_INT || actual == GL_BOOL ||
+                   actual == GL_SAMPLER_2D || actual == GL_SAMPLER_CUBE ||
+                   actual == GL_SAMPLER_2D_ARRAY || actual == GL_SAMPLER_BUFFER ||
+                   actual == GL_SAMPLER_3D;
+    if (intLike && (expected == GL_INT || expected == GL_BOOL)) return;
+
+    std::cout << "WARNING: Uniform '" << name << "' type mismatch in program " << ID << std::endl;
 }
 
@@ -3,24 +3,66 @@
 #include <glad/glad.h>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
+#include "glState.hpp"
+
+// Typed handle to a uniform location. Resolve it once with Shader::uniform<T>()
+// and pass it to Shader::set() every frame; no string hashing or GL queries.
+template<typename T>
+struct UniformHandle {
+    GLint location = -1;
+
+    bool valid() const { return location >= 0; }
+};
+
+struct ShaderDefine {
+    std::string name;
+    std::string value;
+};
+
+// Preprocessed stage sources, safe to produce off the GL thread
+struct ShaderSources {
+    std::string vertex;
+    std::string fragment;
+};
+
+struct UniformInfo {
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
 class Shader {
 public:
     unsigned int ID = 0;
 
     Shader(const char* vertexPath, const char* fragmentPath);
+    // Compiles a permutation: each define is injected right after #version
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<ShaderDefine>& defines);
+
+    // Batch compilation (see ShaderLibrary): load sources on any thread, then
+    // submit every program before finishing any of them so driver compiler
+    // work overlaps.
+    static ShaderSources loadSources(const std::string &vertexPath, const std::string &fragmentPath, const std::vector<ShaderDefine>& defines);
+    explicit Shader(const ShaderSources& sources);
+    bool isReady() const;
+    bool finish();
 
     void use() {
-        glUseProgram(ID);
+        GLState::useProgram(ID);
         currentShader = this;
     };
 
     static void cleanupAll() {
-        glUseProgram(0);
+        GLState::useProgram(0);
         for (auto shaderID : allShaders) {
             glDeleteProgram(shaderID);
+            GLState::forgetProgram(shaderID);
         }
         allShaders.clear();
     }
@@ -29,46 +71,130 @@ public:
         return currentShader;
     }
 
+    // Uniform Table
+    template<typename T>
+    UniformHandle<T> uniform(const std::string &name) const {
+        UniformHandle<T> handle;
+        auto it = uniforms.find(name);
+        if (it != uniforms.end()) {
+            handle.location = it->second.location;
+            checkType(name, it->second.type, glTypeOf<T>());
+        }
+        return handle;
+    }
+
+    bool hasUniform(const std::string &name) const {
+        return uniforms.find(name) != uniforms.end();
+    }
+
+    const std::unordered_map<std::string, UniformInfo>& activeUniforms() const {
+        return uniforms;
+    }
+
+    // Number of by-name uniform lookups issued during the previous frame.
+    // Anything in here is a hot-path caller that should be using a UniformHandle.
+    static unsigned int frameLookups() { return lastFrameLookups; }
+    // Number of glUniform* calls issued during the previous frame
+    static unsigned int frameUploads() { return lastFrameUploads; }
+    static void beginFrame() {
+        lastFrameLookups = lookups;
+        lastFrameUploads = uploads;
+        lookups = 0;
+        uploads = 0;
+    }
+
+    // Handle Set Functions
+    void set(UniformHandle<bool> h, bool value) const { if (h.valid()) { uploads++; glUniform1i(h.location, (int)value); } }
+    void set(UniformHandle<int> h, int value) const { if (h.valid()) { uploads++; glUniform1i(h.location, value); } }
+    void set(UniformHandle<float> h, float value) const { if (h.valid()) { uploads++; glUniform1f(h.location, value); } }
+    void set(UniformHandle<glm::vec2> h, const glm::vec2 &value) const { if (h.valid()) { uploads++; glUniform2fv(h.location, 1, &value[0]); } }
+    void set(UniformHandle<glm::vec3> h, const glm::vec3 &value) const { if (h.valid()) { uploads++; glUniform3fv(h.location, 1, &value[0]); } }
+    void set(UniformHandle<glm::vec4> h, const glm::vec4 &value) const { if (h.valid()) { uploads++; glUniform4fv(h.location, 1, &value[0]); } }
+    void set(UniformHandle<glm::mat2> h, const glm::mat2 &mat) const { if (h.valid()) { uploads++; glUniformMatrix2fv(h.location, 1, GL_FALSE, &mat[0][0]); } }
+    void set(UniformHandle<glm::mat3> h, const glm::mat3 &mat) const { if (h.valid()) { uploads++; glUniformMatrix3fv(h.location, 1, GL_FALSE, &mat[0][0]); } }
+    void set(UniformHandle<glm::mat4> h, const glm::mat4 &mat) const { if (h.valid()) { uploads++; glUniformMatrix4fv(h.location, 1, GL_FALSE, &mat[0][0]); } }
+
     // Set Functions
     void setBool(const std::string &name, bool value) const {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(location(name), (int)value); 
     }
     void setInt(const std::string &name, int value) const { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(location(name), value); 
     }
     void setFloat(const std::string &name, float value) const { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(location(name), value); 
     } 
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(location(name), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(location(name), x, y); 
     }
     void setVec3(const std::string &name, const glm::vec3 &value) const { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(location(name), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(location(name), x, y, z); 
     }
     void setVec4(const std::string &name, const glm::vec4 &value) const { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(location(name), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) const { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(location(name), x, y, z, w); 
     }
     void setMat2(const std::string &name, const glm::mat2 &mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     void setMat3(const std::string &name, const glm::mat3 &mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     void setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
     static std::vector<unsigned int> allShaders;
     static Shader* currentShader;
+
+    inline static unsigned int lookups = 0;
+    inline static unsigned int lastFrameLookups = 0;
+    inline static unsigned int uploads = 0;
+    inline static unsigned int lastFrameUploads = 0;
+
+    std::unordered_map<std::string, UniformInfo> uniforms;
+
+    // In-flight compile state between the constructor and finish()
+    GLuint pendingVertex = 0;
+    GLuint pendingFragment = 0;
+    uint64_t cacheKey = 0;
+    bool finished = false;
+
+    void submit(const ShaderSources& sources);
+    static std::string readSource(const std::string &path, int depth = 0);
+    static std::string injectDefines(const std::string &source, const std::vector<ShaderDefine>& defines);
+    void buildUniformTable();
+    void bindUniformBlocks();
+    void checkType(const std::string &name, GLenum actual, GLenum expected) const;
+
+    GLint location(const std::string &name) const {
+        lookups++;
+        uploads++;
+        auto it = uniforms.find(name);
+        return it != uniforms.end() ? it->second.location : -1;
+    }
+
+    template<typename T>
+    static constexpr GLenum glTypeOf() {
+        if constexpr (std::is_same_v<T, bool>) return GL_BOOL;
+        else if constexpr (std::is_same_v<T, int>) return GL_INT;
+        else if constexpr (std::is_same_v<T, float>) return GL_FLOAT;
+        else if constexpr (std::is_same_v<T, glm::vec2>) return GL_FLOAT_VEC2;
+        else if constexpr (std::is_same_v<T, glm::vec3>) return GL_FLOAT_VEC3;
+        else if constexpr (std::is_same_v<T, glm::vec4>) return GL_FLOAT_VEC4;
+        else if constexpr (std::is_same_v<T, glm::mat2>) return GL_FLOAT_MAT2;
+        else if constexpr (std::is_same_v<T, glm::mat3>) return GL_FLOAT_MAT3;
+        else if constexpr (std::is_same_v<T, glm::mat4>) return GL_FLOAT_MAT4;
+        else return GL_NONE;
+    }
 };
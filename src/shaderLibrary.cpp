@@ -0,0 +1,55 @@
+#include "shaderLibrary.hpp"
+#include "programCache.hpp"
+#include "glExtensions.hpp"
+#include "threadPool.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+void ShaderLibrary::compileAll() {
+    std::vector<ShaderRequest> pending(requests.begin() + shaders.size(), requests.end());
+    for (auto& shader : compileBatch(pending)) {
+        shaders.push_back(std::move(shader));
+    }
+}
+
+std::vector<std::unique_ptr<Shader>> ShaderLibrary::compileBatch(const std::vector<ShaderRequest>& batch) {
+    auto start = std::chrono::steady_clock::now();
+
+    // 1. Read and preprocess every source on the worker pool
+    std::vector<ShaderSources> sources(batch.size());
+    ThreadPool::shared().parallelFor(batch.size(), [&](size_t i) {
+        sources[i] = Shader::loadSources(batch[i].vertexPath, batch[i].fragmentPath, batch[i].defines);
+    });
+
+    // 2. Submit every compile and link without waiting on any of them
+    std::vector<std::unique_ptr<Shader>> shaders;
+    shaders.reserve(batch.size());
+    for (auto& source : sources) {
+        shaders.push_back(std::make_unique<Shader>(source));
+    }
+
+    // 3. Finish programs as the driver completes them
+    std::vector<bool> done(shaders.size(), false);
+    size_t remaining = shaders.size();
+    while (remaining > 0) {
+        bool progressed = false;
+        for (size_t i = 0; i < shaders.size(); i++) {
+            if (done[i] || !shaders[i]->isReady()) continue;
+            shaders[i]->finish();
+            done[i] = true;
+            remaining--;
+            progressed = true;
+        }
+        if (!progressed) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    ProgramCache::recordTime(elapsed.count());
+    if (!batch.empty()) {
+        std::cout << "Shader batch: " << batch.size() << " programs in " << elapsed.count() << " ms"
+                  << (GLExtensions::parallelShaderCompile ? " (parallel compile)" : "") << std::endl;
+    }
+    return shaders;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "shader.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ShaderRequest {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<ShaderDefine> defines;
+};
+
+// Named programs compiled as one batch. Sources are read on worker threads,
+// every compile and link is submitted before any status is queried, and
+// with KHR/ARB_parallel_shader_compile programs are finished in whatever
+// order the driver completes them. Startup then tracks the slowest shader
+// rather than the sum of all of them.
+class ShaderLibrary {
+public:
+    void add(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+             std::vector<ShaderDefine> defines = {}) {
+        names[name] = requests.size();
+        requests.push_back({vertexPath, fragmentPath, std::move(defines)});
+    }
+
+    // Compiles everything added since the last call
+    void compileAll();
+
+    Shader& get(const std::string& name) { return *shaders[names.at(name)]; }
+
+    Shader* find(const std::string& name) {
+        auto it = names.find(name);
+        return it != names.end() && it->second < shaders.size() ? shaders[it->second].get() : nullptr;
+    }
+
+    // Results are in request order
+    static std::vector<std::unique_ptr<Shader>> compileBatch(const std::vector<ShaderRequest>& batch);
+
+private:
+    std::vector<ShaderRequest> requests;
+    std::vector<std::unique_ptr<Shader>> shaders;
+    std::unordered_map<std::string, size_t> names;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "shader.hpp"
+#include "shaderLibrary.hpp"
+#include "animation.hpp"
+#include "vertexAnimation.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compile-time features of the lit shader. Each distinct combination is a
+// separate program with the unused paths compiled out.
+struct ShaderFeatures {
+    unsigned int pointLights = 0;
+    bool dirLight = false;
+    bool spotLight = false;
+    bool specularMap = false;
+    bool textureArrays = false;     // material samples array layers per instance
+    bool skinned = false;           // vertices follow the bone palette
+    bool vertexAnimation = false;   // vertices read baked frames, instances pick clip and time
+
+    uint32_t key() const {
+        return (pointLights & 0xFF) | (dirLight << 8) | (spotLight << 9) | (specularMap << 10) | (textureArrays << 11) |
+               (skinned << 12) | (vertexAnimation << 13);
+    }
+
+    std::vector<ShaderDefine> defines() const {
+        std::vector<ShaderDefine> d;
+        d.push_back({"NR_POINT_LIGHTS", std::to_string(pointLights)});
+        if (dirLight) d.push_back({"HAS_DIR_LIGHT", "1"});
+        if (spotLight) d.push_back({"HAS_SPOT_LIGHT", "1"});
+        if (specularMap) d.push_back({"HAS_SPECULAR_MAP", "1"});
+        if (textureArrays) d.push_back({"TEXTURE_ARRAYS", "1"});
+        if (skinned) {
+            d.push_back({"SKINNED", "1"});
+            d.push_back({"MAX_BONES", std::to_string(MAX_BONES)});
+        }
+        if (vertexAnimation) {
+            d.push_back({"VERTEX_ANIMATION", "1"});
+            d.push_back({"VAT_MAX_CLIPS", std::to_string(VAT_MAX_CLIPS)});
+        }
+        return d;
+    }
+
+    ShaderFeatures operator|(const ShaderFeatures& o) const {
+        ShaderFeatures f;
+        f.pointLights = pointLights > o.pointLights ? pointLights : o.pointLights;
+        f.dirLight = dirLight || o.dirLight;
+        f.spotLight = spotLight || o.spotLight;
+        f.specularMap = specularMap || o.specularMap;
+        f.textureArrays = textureArrays || o.textureArrays;
+        f.skinned = skinned || o.skinned;
+        f.vertexAnimation = vertexAnimation || o.vertexAnimation;
+        return f;
+    }
+};
+
+// Permutations of one vertex/fragment pair, compiled on first use and
+// cached by feature key (and on disk through ProgramCache).
+class ShaderVariants {
+public:
+    ShaderVariants(std::string vertexPath, std::string fragmentPath)
+        : vertexPath(std::move(vertexPath)), fragmentPath(std::move(fragmentPath)) {}
+
+    Shader* get(const ShaderFeatures& features) {
+        auto it = variants.find(features.key());
+        if (it != variants.end()) return it->second.get();
+
+        auto shader = std::make_unique<Shader>(vertexPath.c_str(), fragmentPath.c_str(), features.defines());
+        Shader* ptr = shader.get();
+        variants.emplace(features.key(), std::move(shader));
+        return ptr;
+    }
+
+    // Compiles every missing variant in one batch instead of on first use
+    void precompile(const std::vector<ShaderFeatures>& list) {
+        std::vector<ShaderRequest> batch;
+        std::vector<uint32_t> keys;
+        for (auto& features : list) {
+            uint32_t key = features.key();
+            if (variants.count(key) || std::find(keys.begin(), keys.end(), key) != keys.end()) continue;
+            batch.push_back({vertexPath, fragmentPath, features.defines()});
+            keys.push_back(key);
+        }
+
+        auto compiled = ShaderLibrary::compileBatch(batch);
+        for (size_t i = 0; i < compiled.size(); i++) {
+            variants.emplace(keys[i], std::move(compiled[i]));
+        }
+    }
+
+    size_t count() const { return variants.size(); }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+};
@@ -4,6 +4,10 @@
 #include <iostream>
 
 #include "shader.hpp"
+#include "glState.hpp"
+#include "textureCache.hpp"
+
+#include <future>
 
 class Texture {
 public:
@@ -11,24 +15,62 @@ public:
 
     Texture() = default;
     Texture(const char* path, bool flip = true);
+    Texture(const char* path, const TextureOptions& options);
+
+    // Returns at once with a 1x1 placeholder; the image is decoded on a
+    // worker thread and uploaded by TextureLoader::pump(). Copies and other
+    // loads of the same file share one GL texture through TextureCache.
+    static Texture loadAsync(const char* path, bool flip = true) {
+        return loadAsync(path, flipOptions(flip));
+    }
+
+    static Texture loadAsync(const char* path, const TextureOptions& options) {
+        Texture tex;
+        tex.resource = TextureCache::get(path, options);
+        tex.texture = tex.resource->id;
+        return tex;
+    }
+
+    bool isReady() const {
+        if (!resource || !resource->ready.valid()) return true;
+        return resource->ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
 
     void bind(unsigned int slot, const std::string& uniformName) const {
-        glActiveTexture(GL_TEXTURE0 + slot);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::bindTexture(slot, GL_TEXTURE_2D, texture);
 
         // Ensure shader is active before setting
         Shader::getCurrentShader()->setInt(uniformName.c_str(), slot);
     }
 
+    void bind(unsigned int slot, UniformHandle<int> sampler) const {
+        GLState::bindTexture(slot, GL_TEXTURE_2D, texture);
+
+        Shader::getCurrentShader()->set(sampler, (int)slot);
+    }
+
     void bind(unsigned int slot = 0) const {
-        glActiveTexture(GL_TEXTURE0 + slot);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::bindTexture(slot, GL_TEXTURE_2D, texture);
     }
 
 
     void cleanup() {
-        glDeleteTextures(1, &texture);
+        // Cached textures are deleted when their last handle is released
+        if (resource) {
+            resource.reset();
+        } else {
+            glDeleteTextures(1, &texture);
+            GLState::forgetTexture(texture);
+        }
+        texture = 0;
     }
 private:
+    static TextureOptions flipOptions(bool flip) {
+        TextureOptions options;
+        options.flip = flip;
+        return options;
+    }
+
     unsigned int textures = 0;
+    TextureHandle resource;
 };
@@ -0,0 +1,150 @@
+#include "textureArray.hpp"
+#include "textureCache.hpp"
+#include "threadPool.hpp"
+#include "glState.hpp"
+#include "glExtensions.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+    GLenum uploadFormat(int channels) {
+        if (channels == 1) return GL_RED;
+        if (channels == 2) return GL_RG;
+        return GL_RGBA;     // RGB arrives widened to RGBA
+    }
+}
+
+TextureLayer::~TextureLayer() {
+    TextureArrays::entries.erase(key);
+    if (array != 0) TextureArrays::release(array, layer);
+}
+
+TextureLayerHandle TextureArrays::load(const std::string& path, const TextureOptions& options) {
+    std::string key = TextureCache::key(path, options);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        if (TextureLayerHandle existing = it->second.lock()) return existing;
+    }
+
+    TextureLayerHandle layer = std::make_shared<TextureLayer>();
+    layer->key = key;
+    entries[key] = layer;
+
+    Request request;
+    request.layer = layer;
+    request.path = path;
+    request.srgb = options.srgb;
+    request.decode = ThreadPool::shared().submit([path, options] {
+        return TextureLoader::prepare(path, options);
+    });
+    requests.push_back(std::move(request));
+    return layer;
+}
+
+void TextureArrays::pump(unsigned int maxUploads) {
+    unsigned int uploads = 0;
+    for (size_t i = 0; i < requests.size() && uploads < maxUploads;) {
+        Request& request = requests[i];
+        if (request.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+
+        TextureLoader::PreparedImage image = request.decode.get();
+        TextureLayerHandle layer = request.layer.lock();
+        if (!image.valid()) {
+            std::cout << "Texture failed to load at path: " << request.path << std::endl;
+        } else if (layer) {
+            place(*layer, image, request.srgb);
+            uploads++;
+        }
+        requests.erase(requests.begin() + i);
+    }
+}
+
+void TextureArrays::finishAll() {
+    while (!requests.empty()) {
+        requests.front().decode.wait();
+        pump((unsigned int)requests.size());
+    }
+}
+
+void TextureArrays::place(TextureLayer& layer, const TextureLoader::PreparedImage& image, bool srgb) {
+    Shape shape;
+    shape.width = image.levels[0].width;
+    shape.height = image.levels[0].height;
+    shape.levels = (int)image.levels.size();
+    // RGB is widened on decode, so it can share RGBA8 arrays
+    int channels = image.sourceChannels == 3 ? 4 : image.sourceChannels;
+    shape.internalFormat = TextureLoader::internalFormat(channels, srgb);
+
+    Array& array = arrayFor(shape);
+    int slice = array.freeLayers.back();
+    array.freeLayers.pop_back();
+
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum format = uploadFormat(image.levels[0].channels);
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        const DecodedImage& mip = image.levels[level];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, slice, mip.width, mip.height, 1,
+                        format, GL_UNSIGNED_BYTE, mip.pixels.get());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    layer.array = array.id;
+    layer.layer = slice;
+}
+
+TextureArrays::Array& TextureArrays::arrayFor(const Shape& shape) {
+    for (auto& array : arrays) {
+        if (array.shape == shape && !array.freeLayers.empty()) return array;
+    }
+
+    Array array;
+    array.shape = shape;
+    for (int i = TEXTURE_ARRAY_LAYERS - 1; i >= 0; i--) array.freeLayers.push_back(i);
+
+    glGenTextures(1, &array.id);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+    if (GLExtensions::textureStorage) {
+        GLExtensions::TexStorage3D(GL_TEXTURE_2D_ARRAY, shape.levels, shape.internalFormat,
+                                   shape.width, shape.height, TEXTURE_ARRAY_LAYERS);
+    } else {
+        int width = shape.width, height = shape.height;
+        for (int level = 0; level < shape.levels; level++) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, shape.internalFormat, width, height, TEXTURE_ARRAY_LAYERS, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, shape.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, shape.levels - 1);
+
+    arrays.push_back(std::move(array));
+    return arrays.back();
+}
+
+void TextureArrays::release(GLuint array, int layer) {
+    for (auto& a : arrays) {
+        if (a.id == array) {
+            a.freeLayers.push_back(layer);
+            return;
+        }
+    }
+}
+
+void TextureArrays::cleanup() {
+    finishAll();
+    for (auto& array : arrays) {
+        glDeleteTextures(1, &array.id);
+        GLState::forgetTexture(array.id);
+    }
+    // Handles still alive after this point only return layers to nothing
+    arrays.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "textureLoader.hpp"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TEXTURE_ARRAY_LAYERS 16
+
+// One image living in a slice of a shared GL_TEXTURE_2D_ARRAY. `array` is 0
+// and `layer` -1 until the decode lands on the GL thread.
+struct TextureLayer {
+    GLuint array = 0;
+    int layer = -1;
+    std::string key;
+
+    bool ready() const { return array != 0; }
+    ~TextureLayer();
+};
+
+using TextureLayerHandle = std::shared_ptr<TextureLayer>;
+
+// Packs same-size, same-format textures into 2D array slices so materials
+// become a pair of layer indices and objects with different textures can
+// share one bind and one draw. Images are decoded on the ThreadPool and
+// placed by pump(); a layer is recycled when its last handle goes away.
+class TextureArrays {
+public:
+    static TextureLayerHandle load(const std::string& path, const TextureOptions& options = TextureOptions());
+
+    // GL thread, once per frame
+    static void pump(unsigned int maxUploads = 4);
+    static void finishAll();
+
+    static size_t arrayCount() { return arrays.size(); }
+    static size_t pending() { return requests.size(); }
+    static void cleanup();
+
+private:
+    friend struct TextureLayer;
+
+    struct Shape {
+        int width = 0;
+        int height = 0;
+        int levels = 0;
+        GLenum internalFormat = GL_RGBA8;
+
+        bool operator==(const Shape& o) const {
+            return width == o.width && height == o.height && levels == o.levels && internalFormat == o.internalFormat;
+        }
+    };
+
+    struct Array {
+        GLuint id = 0;
+        Shape shape;
+        std::vector<int> freeLayers;
+    };
+
+    struct Request {
+        std::weak_ptr<TextureLayer> layer;
+        std::string path;
+        bool srgb = false;
+        std::future<TextureLoader::PreparedImage> decode;
+    };
+
+    inline static std::vector<Array> arrays;
+    inline static std::vector<Request> requests;
+    inline static std::unordered_map<std::string, std::weak_ptr<TextureLayer>> entries;
+
+    static void place(TextureLayer& layer, const TextureLoader::PreparedImage& image, bool srgb);
+    static Array& arrayFor(const Shape& shape);
+    static void release(GLuint array, int layer);
+};
@@ -0,0 +1,149 @@
+#include "textureBaker.hpp"
+#include "blockCompress.hpp"
+#include "imageDecode.hpp"
+#include "mipGenerator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+
+namespace {
+    // Widens any channel count to RGBA8. Two-channel (grey + alpha) images
+    // move alpha into G so BC5 stores them the way GL_RG uploads them.
+    DecodedImage expand(const DecodedImage& image) {
+        DecodedImage out;
+        out.width = image.width;
+        out.height = image.height;
+        out.channels = 4;
+        out.pixels = std::shared_ptr<unsigned char>(new unsigned char[out.size()], std::default_delete<unsigned char[]>());
+
+        const unsigned char* src = image.pixels.get();
+        size_t count = (size_t)image.width * image.height;
+        for (size_t i = 0; i < count; i++) {
+            unsigned char* dst = out.pixels.get() + i * 4;
+            const unsigned char* s = src + i * image.channels;
+            switch (image.channels) {
+                case 1: dst[0] = dst[1] = dst[2] = s[0]; dst[3] = 255; break;
+                case 2: dst[0] = s[0]; dst[1] = s[1]; dst[2] = 0; dst[3] = 255; break;
+                case 3: dst[0] = s[0]; dst[1] = s[1]; dst[2] = s[2]; dst[3] = 255; break;
+                default: dst[0] = s[0]; dst[1] = s[1]; dst[2] = s[2]; dst[3] = s[3]; break;
+            }
+        }
+        return out;
+    }
+
+    BlockFormat chooseFormat(const DecodedImage& image, const DecodedImage& rgba) {
+        if (image.channels == 1) return BlockFormat::BC4;
+        if (image.channels == 2) return BlockFormat::BC5;
+        if (image.channels == 3) return BlockFormat::BC1;
+
+        // Fully opaque RGBA gains nothing from BC3's alpha block
+        const unsigned char* pixels = rgba.pixels.get();
+        for (size_t i = 3; i < rgba.size(); i += 4) {
+            if (pixels[i] != 255) return BlockFormat::BC3;
+        }
+        return BlockFormat::BC1;
+    }
+}
+
+BakeResult bakeTexture(const std::string& source, const std::string& output, const BakeOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    BakeResult result;
+
+    DecodedImage image = decodeImage(source, options.flip);
+    if (!image.valid()) return result;
+
+    DecodedImage rgba = expand(image);
+    result.format = chooseFormat(image, rgba);
+    result.width = (uint32_t)image.width;
+    result.height = (uint32_t)image.height;
+
+    // Same filter as the runtime path, so baked and decoded mips match
+    bool linearLight = options.color || options.srgb;
+    std::vector<DecodedImage> chain = options.mipmaps ? buildMipChain(rgba, linearLight) : std::vector<DecodedImage>{rgba};
+
+    std::vector<BakedLevel> levels;
+    for (auto& level : chain) {
+        BakedLevel baked;
+        baked.width = (uint32_t)level.width;
+        baked.height = (uint32_t)level.height;
+        baked.data = compressImage(level.pixels.get(), level.width, level.height, result.format);
+        result.bakedBytes += baked.data.size();
+        result.uncompressedBytes += level.size();
+        levels.push_back(std::move(baked));
+    }
+    result.levels = (uint32_t)levels.size();
+
+    uint32_t flags = options.flip ? TEXTURE_CONTAINER_FLIPPED : 0;
+    result.ok = writeTextureContainer(output, result.format, flags, levels);
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+BakeResult bakeCubemap(const std::vector<std::vector<DecodedImage>>& faces, const std::string& output, bool compress) {
+    auto start = std::chrono::steady_clock::now();
+    BakeResult result;
+    if (faces.size() != 6) return result;
+    for (auto& face : faces) {
+        if (face.empty() || face[0].channels != 4 || face.size() != faces[0].size()) return result;
+    }
+
+    result.format = BlockFormat::RGBA8;
+    if (compress) {
+        result.format = BlockFormat::BC1;
+        for (auto& face : faces) {
+            if (chooseFormat(face[0], face[0]) == BlockFormat::BC3) result.format = BlockFormat::BC3;
+        }
+    }
+    result.width = (uint32_t)faces[0][0].width;
+    result.height = (uint32_t)faces[0][0].height;
+    result.levels = (uint32_t)faces[0].size();
+
+    std::vector<BakedLevel> levels;
+    for (auto& face : faces) {
+        for (auto& level : face) {
+            BakedLevel baked;
+            baked.width = (uint32_t)level.width;
+            baked.height = (uint32_t)level.height;
+            baked.data = compressImage(level.pixels.get(), level.width, level.height, result.format);
+            result.bakedBytes += baked.data.size();
+            result.uncompressedBytes += level.size();
+            levels.push_back(std::move(baked));
+        }
+    }
+
+    result.ok = writeTextureContainer(output, result.format, TEXTURE_CONTAINER_CUBE, levels);
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool looksLikeDataTexture(const std::string& source) {
+    std::string name = std::filesystem::path(source).stem().string();
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (const char* hint : {"spec", "normal", "rough", "metal", "height", "ao", "gloss", "mask"}) {
+        if (name == hint || name.find(std::string("_") + hint) != std::string::npos ||
+            name.rfind(std::string(hint) + "_", 0) == 0) return true;
+    }
+    return false;
+}
+
+bool bakedTextureCurrent(const std::string& source) {
+    std::error_code ec;
+    auto bakedTime = std::filesystem::last_write_time(bakedTexturePath(source), ec);
+    if (ec) return false;
+    auto sourceTime = std::filesystem::last_write_time(source, ec);
+    return ec || bakedTime >= sourceTime;
+}
+
+bool bakedCubemapCurrent(const std::vector<std::string>& faces) {
+    if (faces.size() != 6) return false;
+    std::error_code ec;
+    auto bakedTime = std::filesystem::last_write_time(bakedCubemapPath(faces), ec);
+    if (ec) return false;
+    for (auto& face : faces) {
+        auto sourceTime = std::filesystem::last_write_time(face, ec);
+        if (!ec && sourceTime > bakedTime) return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "textureContainer.hpp"
+#include "imageDecode.hpp"
+
+#include <string>
+#include <vector>
+
+struct BakeOptions {
+    bool flip = true;       // match TextureOptions::flip of the runtime load
+    bool mipmaps = true;
+    bool color = true;      // filter mips in linear light; off for normal/specular/AO data
+    bool srgb = false;      // match TextureOptions::srgb; sampled as sRGB, so also filtered in linear light
+};
+
+struct BakeResult {
+    bool ok = false;
+    BlockFormat format = BlockFormat::BC1;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    size_t uncompressedBytes = 0;   // what the RGBA8 + glGenerateMipmap path would use
+    size_t bakedBytes = 0;
+    double milliseconds = 0.0;
+};
+
+// Decodes a source image, builds its mip chain and writes it block-compressed
+// to `output`. CPU only; safe to run on worker threads.
+BakeResult bakeTexture(const std::string& source, const std::string& output, const BakeOptions& options = BakeOptions());
+
+// Writes six RGBA8 faces, each with its mip chain already built, as one
+// cubemap container: BC1 (BC3 if any texel is translucent) when `compress`
+// is set, raw RGBA8 otherwise. CPU only; safe to run on worker threads.
+BakeResult bakeCubemap(const std::vector<std::vector<DecodedImage>>& faces, const std::string& output, bool compress);
+
+// Guesses from the file name whether an image holds data rather than color
+bool looksLikeDataTexture(const std::string& source);
+
+// True when the baked container exists and is newer than its source
+bool bakedTextureCurrent(const std::string& source);
+bool bakedCubemapCurrent(const std::vector<std::string>& faces);
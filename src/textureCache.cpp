@@ -0,0 +1,68 @@
+#include "textureCache.hpp"
+#include "glState.hpp"
+#include "textureStreamer.hpp"
+
+#include <filesystem>
+
+TextureResource::~TextureResource() {
+    TextureCache::entries.erase(key);
+    if (!TextureCache::contextAlive || id == 0) return;
+
+    TextureLoader::cancel(id);
+    TextureStreamer::forget(id);
+    glDeleteTextures(1, &id);
+    GLState::forgetTexture(id);
+}
+
+std::string TextureCache::key(const std::string& path, const TextureOptions& options) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(path, ec), ec);
+    std::string key = ec ? path : canonical.generic_string();
+
+    key += options.flip ? "|flip" : "|noflip";
+    key += options.srgb ? "|srgb" : "|linear";
+    key += options.color ? "|color" : "|data";
+    key += options.mipmaps ? "|mips" : "|nomips";
+    key += "|wrap" + std::to_string(options.wrap);
+    if (options.stream) key += "|stream";
+    return key;
+}
+
+TextureHandle TextureCache::get(const std::string& path, const TextureOptions& options) {
+    std::string k = key(path, options);
+
+    auto it = entries.find(k);
+    if (it != entries.end()) {
+        if (TextureHandle existing = it->second.lock()) {
+            hits++;
+            return existing;
+        }
+    }
+
+    TextureHandle resource = std::make_shared<TextureResource>();
+    resource->key = k;
+
+    std::weak_ptr<TextureResource> weak = resource;
+    TextureLoader::Handle handle = TextureLoader::load2D(path, options, [weak](unsigned int, size_t bytes) {
+        if (TextureHandle alive = weak.lock()) alive->bytes = bytes;
+    });
+    resource->id = handle.id;
+    resource->ready = handle.ready;
+
+    entries[k] = resource;
+    loads++;
+    return resource;
+}
+
+TextureCacheStats TextureCache::stats() {
+    TextureCacheStats s;
+    s.loads = loads;
+    s.hits = hits;
+    for (auto& [key, weak] : entries) {
+        if (TextureHandle alive = weak.lock()) {
+            s.resident++;
+            s.bytes += alive->bytes;
+        }
+    }
+    return s;
+}
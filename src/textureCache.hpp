@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "textureLoader.hpp"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// One GL texture shared by every holder of its handle; deleted when the
+// last handle goes away.
+struct TextureResource {
+    unsigned int id = 0;
+    size_t bytes = 0;
+    std::string key;
+    std::shared_future<unsigned int> ready;
+
+    ~TextureResource();
+};
+
+using TextureHandle = std::shared_ptr<TextureResource>;
+
+struct TextureCacheStats {
+    size_t resident = 0;    // live textures
+    size_t bytes = 0;       // estimated GPU memory of live textures
+    unsigned int loads = 0;
+    unsigned int hits = 0;
+};
+
+// Process-wide texture cache keyed by canonical absolute path plus the load
+// options, so every model and object referencing an image shares one upload.
+class TextureCache {
+public:
+    static TextureHandle get(const std::string& path, const TextureOptions& options = TextureOptions());
+
+    static TextureCacheStats stats();
+
+    // Called before the GL context goes away; later releases skip GL calls
+    static void shutdown() { contextAlive = false; }
+    // False after shutdown(): GL objects owned elsewhere went with the context too
+    static bool hasContext() { return contextAlive; }
+
+    // Canonical path plus every option that changes the uploaded texels
+    static std::string key(const std::string& path, const TextureOptions& options);
+
+private:
+    friend struct TextureResource;
+
+    inline static std::unordered_map<std::string, std::weak_ptr<TextureResource>> entries;
+    inline static unsigned int loads = 0;
+    inline static unsigned int hits = 0;
+    inline static bool contextAlive = true;
+};
@@ -0,0 +1,137 @@
+#include "textureContainer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    const uint32_t CONTAINER_MAGIC = 0x58455447; // "GTEX"
+    const uint32_t CONTAINER_VERSION = 1;
+
+    struct ContainerHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;
+        uint32_t flags;
+        uint32_t levelCount;
+        uint32_t reserved;
+    };
+
+    struct LevelEntry {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    bool knownFormat(uint32_t format) {
+        return format == (uint32_t)BlockFormat::BC1 || format == (uint32_t)BlockFormat::BC3 ||
+               format == (uint32_t)BlockFormat::BC4 || format == (uint32_t)BlockFormat::BC5 ||
+               format == (uint32_t)BlockFormat::RGBA8;
+    }
+}
+
+size_t blockBytes(BlockFormat format) {
+    if (format == BlockFormat::RGBA8) return 4;     // a "block" is one texel
+    return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t compressedLevelSize(BlockFormat format, uint32_t width, uint32_t height) {
+    if (format == BlockFormat::RGBA8) return (size_t)std::max<uint32_t>(1, width) * std::max<uint32_t>(1, height) * 4;
+    size_t blocksX = std::max<uint32_t>(1, (width + 3) / 4);
+    size_t blocksY = std::max<uint32_t>(1, (height + 3) / 4);
+    return blocksX * blocksY * blockBytes(format);
+}
+
+const char* blockFormatName(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC4: return "BC4";
+        case BlockFormat::BC5: return "BC5";
+        case BlockFormat::RGBA8: return "RGBA8";
+    }
+    return "?";
+}
+
+bool TextureContainer::open(const std::string& path) {
+    levelTable.clear();
+    if (!file.open(path)) return false;
+
+    const unsigned char* base = file.data();
+    size_t size = file.size();
+    if (size < sizeof(ContainerHeader)) return false;
+
+    ContainerHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != CONTAINER_MAGIC || header.version != CONTAINER_VERSION) return false;
+    if (!knownFormat(header.format)) return false;
+    uint32_t faceCount = (header.flags & TEXTURE_CONTAINER_CUBE) ? 6 : 1;
+    if (header.levelCount == 0 || header.levelCount % faceCount != 0 || header.levelCount > 32 * faceCount) return false;
+
+    size_t tableEnd = sizeof(ContainerHeader) + header.levelCount * sizeof(LevelEntry);
+    if (size < tableEnd) return false;
+
+    blockFormat = (BlockFormat)header.format;
+    flags = header.flags;
+
+    std::vector<TextureLevel> levels;
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        LevelEntry entry;
+        std::memcpy(&entry, base + sizeof(ContainerHeader) + i * sizeof(LevelEntry), sizeof(entry));
+        if (entry.offset > size || entry.size > size - entry.offset) return false;
+        if (entry.size != compressedLevelSize(blockFormat, entry.width, entry.height)) return false;
+
+        TextureLevel level;
+        level.width = entry.width;
+        level.height = entry.height;
+        level.data = base + entry.offset;
+        level.size = (size_t)entry.size;
+        levels.push_back(level);
+    }
+
+    levelTable = std::move(levels);
+    return true;
+}
+
+size_t TextureContainer::bytes() const {
+    size_t total = 0;
+    for (auto& level : levelTable) total += level.size;
+    return total;
+}
+
+bool writeTextureContainer(const std::string& path, BlockFormat format, uint32_t flags,
+                           const std::vector<BakedLevel>& levels) {
+    if (levels.empty()) return false;
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+    // Write to a temporary name first so a crash never leaves a torn file
+    std::string temp = path + ".tmp";
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    ContainerHeader header{CONTAINER_MAGIC, CONTAINER_VERSION, (uint32_t)format, flags, (uint32_t)levels.size(), 0};
+    out.write((const char*)&header, sizeof(header));
+
+    uint64_t offset = sizeof(ContainerHeader) + levels.size() * sizeof(LevelEntry);
+    for (auto& level : levels) {
+        LevelEntry entry{level.width, level.height, offset, level.data.size()};
+        out.write((const char*)&entry, sizeof(entry));
+        offset += level.data.size();
+    }
+    for (auto& level : levels) {
+        out.write((const char*)level.data.data(), (std::streamsize)level.data.size());
+    }
+    out.close();
+    if (!out) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "mappedFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Block-compressed formats a baked texture can hold. GL-free so the offline
+// baker can share this header; TextureLoader maps them to GL enums.
+enum class BlockFormat : uint32_t {
+    BC1 = 1,    // RGB, 8 bytes per 4x4 block
+    BC3 = 3,    // RGBA, 16 bytes per block
+    BC4 = 4,    // R, 8 bytes per block
+    BC5 = 5,    // RG, 16 bytes per block
+    RGBA8 = 8,  // uncompressed, for caches written where the driver lacks S3TC
+};
+
+#define TEXTURE_CONTAINER_FLIPPED 0x1u
+#define TEXTURE_CONTAINER_CUBE 0x2u     // six faces, each a full mip chain, in GL face order
+
+size_t blockBytes(BlockFormat format);
+size_t compressedLevelSize(BlockFormat format, uint32_t width, uint32_t height);
+const char* blockFormatName(BlockFormat format);
+
+// Baked files sit next to their source: "foo.png" -> "foo.png.gtex"
+inline std::string bakedTexturePath(const std::string& source) { return source + ".gtex"; }
+// A cubemap is cached next to its first (+X) face
+inline std::string bakedCubemapPath(const std::vector<std::string>& faces) { return faces[0] + ".cube.gtex"; }
+
+struct TextureLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// Read side of the ".gtex" container: a small header, a level table and the
+// compressed levels, all served straight from a memory mapping.
+class TextureContainer {
+public:
+    bool open(const std::string& path);
+    bool valid() const { return !levelTable.empty(); }
+
+    BlockFormat format() const { return blockFormat; }
+    bool flipped() const { return (flags & TEXTURE_CONTAINER_FLIPPED) != 0; }
+    bool cube() const { return (flags & TEXTURE_CONTAINER_CUBE) != 0; }
+    uint32_t width() const { return levelTable.empty() ? 0 : levelTable[0].width; }
+    uint32_t height() const { return levelTable.empty() ? 0 : levelTable[0].height; }
+    // Every level of every face, face by face
+    const std::vector<TextureLevel>& levels() const { return levelTable; }
+    size_t faces() const { return cube() ? 6 : 1; }
+    size_t mipCount() const { return levelTable.size() / faces(); }
+    const TextureLevel& level(size_t face, size_t mip) const { return levelTable[face * mipCount() + mip]; }
+    size_t bytes() const;
+
+private:
+    MappedFile file;
+    BlockFormat blockFormat = BlockFormat::BC1;
+    uint32_t flags = 0;
+    std::vector<TextureLevel> levelTable;
+};
+
+// Level data must already be compressed in `format`, largest level first
+// (per face for cubemaps)
+struct BakedLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<unsigned char> data;
+};
+
+bool writeTextureContainer(const std::string& path, BlockFormat format, uint32_t flags,
+                           const std::vector<BakedLevel>& levels);
@@ -0,0 +1,424 @@
+#include "textureLoader.hpp"
+#include "threadPool.hpp"
+#include "glState.hpp"
+#include "glExtensions.hpp"
+#include "textureBaker.hpp"
+#include "mipGenerator.hpp"
+#include "textureStreamer.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const unsigned char PLACEHOLDER_PIXEL[4] = {128, 128, 128, 255};
+    const size_t PBO_RING_SIZE = 4;
+
+    GLenum formatFor(int channels) {
+        if (channels == 1) return GL_RED;
+        if (channels == 2) return GL_RG;
+        if (channels == 4) return GL_RGBA;
+        return GL_RGB;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TextureLoader::Handle TextureLoader::load2D(const std::string& path, const TextureOptions& options,
+                                            std::function<void(unsigned int, size_t)> onReady) {
+    auto request = std::make_unique<Request>();
+    request->target = GL_TEXTURE_2D;
+    request->options = options;
+    request->paths = {path};
+    request->onReady = std::move(onReady);
+    return enqueue(std::move(request));
+}
+
+TextureLoader::Handle TextureLoader::loadCube(const std::vector<std::string>& faces,
+                                              std::function<void(unsigned int, size_t)> onReady) {
+    auto request = std::make_unique<Request>();
+    request->target = GL_TEXTURE_CUBE_MAP;
+    request->options.flip = false;
+    request->options.color = true;
+    request->options.wrap = GL_CLAMP_TO_EDGE;
+    request->paths = faces;
+    request->onReady = std::move(onReady);
+    return enqueue(std::move(request));
+}
+
+TextureLoader::Handle TextureLoader::enqueue(std::unique_ptr<Request> request) {
+    // Placeholder storage so the name can be bound and sampled right away
+    glGenTextures(1, &request->texture);
+    GLState::bindTexture(request->target, request->texture);
+
+    GLenum wrap = request->options.wrap;
+    glTexParameteri(request->target, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(request->target, GL_TEXTURE_WRAP_T, wrap);
+    if (request->target == GL_TEXTURE_CUBE_MAP) glTexParameteri(request->target, GL_TEXTURE_WRAP_R, wrap);
+    glTexParameteri(request->target, GL_TEXTURE_MIN_FILTER, request->options.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(request->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (request->target == GL_TEXTURE_CUBE_MAP) {
+        for (unsigned int i = 0; i < 6; i++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+        }
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+    }
+    glTexParameteri(request->target, GL_TEXTURE_MAX_LEVEL, 0);
+
+    if (request->target == GL_TEXTURE_2D) request->baked = openBaked(request->paths[0], request->options);
+    else request->baked = openBakedCube(request->paths, request->options);
+
+    // Decode and build mips for every image (every cube face) in parallel
+    TextureOptions options = request->options;
+    bool timed = request->target == GL_TEXTURE_2D;
+    for (size_t i = 0; i < request->paths.size() && !request->baked; i++) {
+        std::string path = request->paths[i];
+        request->decodes.push_back(ThreadPool::shared().submit([path, options, timed] {
+            auto start = std::chrono::steady_clock::now();
+            PreparedImage image = prepare(path, options);
+            if (timed) {
+                decodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            }
+            return image;
+        }));
+    }
+
+    Handle handle;
+    handle.id = request->texture;
+    handle.ready = request->promise.get_future().share();
+    requests.push_back(std::move(request));
+    return handle;
+}
+
+bool TextureLoader::decoded(const Request& request) {
+    for (auto& decode : request.decodes) {
+        if (decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    }
+    return true;
+}
+
+void TextureLoader::pump(unsigned int maxUploads) {
+    unsigned int uploads = 0;
+    for (size_t i = 0; i < requests.size() && uploads < maxUploads;) {
+        if (!decoded(*requests[i])) {
+            i++;
+            continue;
+        }
+        upload(*requests[i]);
+        requests.erase(requests.begin() + i);
+        uploads++;
+    }
+}
+
+void TextureLoader::finishAll() {
+    while (!requests.empty()) {
+        for (auto& decode : requests.front()->decodes) decode.wait();
+        pump((unsigned int)requests.size());
+    }
+}
+
+void TextureLoader::finish(unsigned int texture) {
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i]->texture != texture) continue;
+        for (auto& decode : requests[i]->decodes) decode.wait();
+        upload(*requests[i]);
+        requests.erase(requests.begin() + i);
+        return;
+    }
+}
+
+void TextureLoader::cancel(unsigned int texture) {
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i]->texture == texture) {
+            requests.erase(requests.begin() + i);
+            return;
+        }
+    }
+}
+
+void TextureLoader::upload(Request& request) {
+    if (request.baked) {
+        GLState::bindTexture(request.target, request.texture);
+        const TextureContainer& baked = *request.baked;
+        GLint base = request.options.stream && request.options.mipmaps
+            ? TextureStreamer::tailLevel((int)baked.width(), (int)baked.height(), (int)baked.mipCount()) : 0;
+        size_t bytes = uploadBaked(baked, request.options, base);
+        if (request.options.stream) {
+            TextureStreamer::track(request.texture, request.paths[0], request.options, request.baked, PreparedImage(), base);
+        }
+        request.baked.reset();
+        request.promise.set_value(request.texture);
+        if (request.onReady) request.onReady(request.texture, bytes);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PreparedImage> faces;
+    for (size_t i = 0; i < request.decodes.size(); i++) {
+        PreparedImage image = request.decodes[i].get();
+        if (!image.valid()) {
+            std::cout << "Texture failed to load at path: " << request.paths[i] << std::endl;
+        }
+        faces.push_back(std::move(image));
+    }
+
+    GLState::bindTexture(request.target, request.texture);
+    bool streamed = request.options.stream && request.options.mipmaps && request.target == GL_TEXTURE_2D && faces[0].valid();
+    GLint base = streamed
+        ? TextureStreamer::tailLevel(faces[0].levels[0].width, faces[0].levels[0].height, (int)faces[0].levels.size()) : 0;
+    size_t bytes = uploadFaces(request.target, faces, request.options, base);
+    if (streamed) {
+        TextureStreamer::track(request.texture, request.paths[0], request.options, nullptr, std::move(faces[0]), base);
+    }
+    if (request.target == GL_TEXTURE_CUBE_MAP) cacheCubemap(request.paths, faces);
+
+    if (request.target == GL_TEXTURE_2D) {
+        stats.decoded++;
+        stats.decodedBytes += bytes;
+        stats.decodedMilliseconds += millisecondsSince(start);
+    }
+
+    request.promise.set_value(request.texture);
+    if (request.onReady) request.onReady(request.texture, bytes);
+}
+
+GLenum TextureLoader::compressedFormat(BlockFormat format, bool srgb) {
+    switch (format) {
+        case BlockFormat::BC1:
+            if (srgb) return GLExtensions::textureCompressionS3TCsRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : 0;
+            return GLExtensions::textureCompressionS3TC ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+        case BlockFormat::BC3:
+            if (srgb) return GLExtensions::textureCompressionS3TCsRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : 0;
+            return GLExtensions::textureCompressionS3TC ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+        // One- and two-channel images are never sRGB, same as the decoded path
+        case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::RGBA8: return 0;     // not compressed; uploadBaked handles it
+    }
+    return 0;
+}
+
+// Sized, as glTexStorage2D requires
+GLenum TextureLoader::internalFormat(int sourceChannels, bool srgb) {
+    if (sourceChannels == 1) return GL_R8;
+    if (sourceChannels == 2) return GL_RG8;
+    if (sourceChannels == 3) return srgb ? GL_SRGB8 : GL_RGB8;
+    return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+TextureLoader::PreparedImage TextureLoader::prepare(const std::string& path, const TextureOptions& options) {
+    PreparedImage prepared;
+    DecodedImage image = decodeImage(path, options.flip);
+    if (!image.valid()) return prepared;
+
+    prepared.sourceChannels = image.channels;
+    image = expandToRGBA(image);
+    if (options.mipmaps) {
+        prepared.levels = buildMipChain(image, options.color || options.srgb);
+    } else {
+        prepared.levels.push_back(image);
+    }
+    return prepared;
+}
+
+size_t TextureLoader::uploadFaces(GLenum target, const std::vector<PreparedImage>& faces, const TextureOptions& options,
+                                  GLint baseLevel) {
+    // Cube faces share one size; storage follows the first face that decoded
+    const PreparedImage* first = nullptr;
+    for (auto& face : faces) {
+        if (face.valid()) {
+            first = &face;
+            break;
+        }
+    }
+    if (!first) return 0;
+
+    const DecodedImage& base = first->levels[0];
+    GLsizei levels = (GLsizei)first->levels.size();
+    GLenum internalFormat = TextureLoader::internalFormat(first->sourceChannels, options.srgb);
+
+    // Allocated once, all levels at a time; the driver never has to
+    // reallocate or validate mip completeness again. Streamed textures stay
+    // mutable so TextureStreamer can free levels.
+    bool immutable = GLExtensions::textureStorage && !options.stream;
+    if (immutable) GLExtensions::TexStorage2D(target, levels, internalFormat, base.width, base.height);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t bytes = 0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        if (!faces[i].valid() || (GLsizei)faces[i].levels.size() != levels) continue;
+        GLenum face = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum)i : GL_TEXTURE_2D;
+        for (GLsizei level = baseLevel; level < levels; level++) {
+            bytes += uploadImage(face, level, faces[i].levels[level], internalFormat, immutable);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    return bytes;
+}
+
+size_t TextureLoader::uploadImage(GLenum faceTarget, GLint level, const DecodedImage& image,
+                                  GLenum internalFormat, bool immutable) {
+    if (pbos.empty()) {
+        pbos.resize(PBO_RING_SIZE);
+        glGenBuffers((GLsizei)pbos.size(), pbos.data());
+    }
+
+    // Round-robin PBOs so a new copy never waits on the previous transfer
+    GLuint pbo = pbos[nextPbo];
+    nextPbo = (nextPbo + 1) % pbos.size();
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, image.size(), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.size(),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    GLenum format = formatFor(image.channels);
+    const void* pixels = nullptr;   // offset 0 into the PBO
+    if (mapped) {
+        std::memcpy(mapped, image.pixels.get(), image.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pixels = image.pixels.get();
+    }
+
+    if (immutable) {
+        glTexSubImage2D(faceTarget, level, 0, 0, image.width, image.height, format, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        glTexImage2D(faceTarget, level, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // RGB arrives widened to RGBA, which is also what drivers store
+    return image.size();
+}
+
+std::shared_ptr<TextureContainer> TextureLoader::openBaked(const std::string& path, const TextureOptions& options) {
+    if (!bakedTextureCurrent(path)) return nullptr;
+
+    auto container = std::make_shared<TextureContainer>();
+    if (!container->open(bakedTexturePath(path))) {
+        std::cout << "Ignoring unreadable baked texture: " << bakedTexturePath(path) << std::endl;
+        return nullptr;
+    }
+    if (container->flipped() != options.flip) {
+        std::cout << "Baked texture " << bakedTexturePath(path) << " has the wrong orientation; decoding source" << std::endl;
+        return nullptr;
+    }
+    if (container->cube() || compressedFormat(container->format(), options.srgb) == 0) return nullptr;
+    return container;
+}
+
+std::shared_ptr<TextureContainer> TextureLoader::openBakedCube(const std::vector<std::string>& faces, const TextureOptions& options) {
+    if (!bakedCubemapCurrent(faces)) return nullptr;
+
+    auto container = std::make_shared<TextureContainer>();
+    if (!container->open(bakedCubemapPath(faces)) || !container->cube()) {
+        std::cout << "Ignoring unreadable cubemap cache: " << bakedCubemapPath(faces) << std::endl;
+        return nullptr;
+    }
+    // A cache compressed on another machine may not be sampleable here
+    if (container->format() != BlockFormat::RGBA8 && compressedFormat(container->format(), options.srgb) == 0) return nullptr;
+    return container;
+}
+
+size_t TextureLoader::uploadBaked(const TextureContainer& container, const TextureOptions& options, GLint baseLevel) {
+    auto start = std::chrono::steady_clock::now();
+    GLenum target = container.cube() ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    bool raw = container.format() == BlockFormat::RGBA8;
+    GLenum format = raw ? internalFormat(4, options.srgb) : compressedFormat(container.format(), options.srgb);
+
+    // Levels come straight from the mapping; no decode, no glGenerateMipmap
+    size_t count = options.mipmaps ? container.mipCount() : 1;
+    bool immutable = GLExtensions::textureStorage && !options.stream;
+    if (immutable) GLExtensions::TexStorage2D(target, (GLsizei)count, format, container.width(), container.height());
+
+    size_t bytes = 0;
+    for (size_t face = 0; face < container.faces(); face++) {
+        GLenum faceTarget = container.cube() ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum)face : GL_TEXTURE_2D;
+        for (size_t i = baseLevel; i < count; i++) {
+            const TextureLevel& level = container.level(face, i);
+            if (raw && immutable) {
+                glTexSubImage2D(faceTarget, (GLint)i, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+            } else if (raw) {
+                glTexImage2D(faceTarget, (GLint)i, format, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+            } else if (immutable) {
+                glCompressedTexSubImage2D(faceTarget, (GLint)i, 0, 0, level.width, level.height, format,
+                                          (GLsizei)level.size, level.data);
+            } else {
+                glCompressedTexImage2D(faceTarget, (GLint)i, format, level.width, level.height, 0,
+                                       (GLsizei)level.size, level.data);
+            }
+            bytes += level.size;
+        }
+    }
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, (GLint)count - 1);
+
+    stats.baked++;
+    stats.bakedBytes += bytes;
+    stats.bakedMilliseconds += millisecondsSince(start);
+    return bytes;
+}
+
+void TextureLoader::cacheCubemap(const std::vector<std::string>& paths, const std::vector<PreparedImage>& faces) {
+    std::vector<std::vector<DecodedImage>> chains;
+    for (auto& face : faces) {
+        if (!face.valid()) return;
+        chains.push_back(face.levels);
+    }
+
+    // Compressed only when this driver could load it back that way
+    bool compress = CUBEMAP_CACHE_COMPRESSED && GLExtensions::textureCompressionS3TC;
+    std::string output = bakedCubemapPath(paths);
+    ThreadPool::shared().submit([chains = std::move(chains), output, compress] {
+        BakeResult result = bakeCubemap(chains, output, compress);
+        if (!result.ok) std::cout << "Failed to write cubemap cache: " << output << std::endl;
+    });
+}
+
+bool TextureLoader::loadBaked(const std::string& path, const TextureOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<TextureContainer> container = openBaked(path, options);
+    if (!container) return false;
+
+    // Count the mapping too; uploadBaked times the upload itself
+    stats.bakedMilliseconds += millisecondsSince(start);
+    uploadBaked(*container, options);
+    return true;
+}
+
+bool TextureLoader::loadNow(const std::string& path, const TextureOptions& options) {
+    if (loadBaked(path, options)) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    PreparedImage image = prepare(path, options);
+    if (!image.valid()) return false;
+
+    size_t bytes = uploadFaces(GL_TEXTURE_2D, {image}, options);
+    stats.decoded++;
+    stats.decodedBytes += bytes;
+    stats.decodedMilliseconds += millisecondsSince(start);
+    return true;
+}
+
+TextureLoadStats TextureLoader::GetStats() {
+    TextureLoadStats s = stats;
+    s.decodedMilliseconds += decodeMicroseconds.load() / 1000.0;
+    return s;
+}
+
+void TextureLoader::cleanup() {
+    finishAll();
+    if (!pbos.empty()) {
+        glDeleteBuffers((GLsizei)pbos.size(), pbos.data());
+        pbos.clear();
+    }
+}
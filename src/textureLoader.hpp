@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "imageDecode.hpp"
+#include "textureContainer.hpp"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cubemaps are cached after their first decode; block-compress that cache
+// (BC1/BC3) when the driver supports S3TC, otherwise store RGBA8
+#define CUBEMAP_CACHE_COMPRESSED 1
+
+struct TextureOptions {
+    bool flip = true;
+    bool srgb = false;      // sample through an sRGB format (decoded to linear by GL)
+    bool color = false;     // sRGB-encoded color: mips are filtered in linear light
+    bool mipmaps = true;
+    GLenum wrap = GL_REPEAT;
+    bool stream = false;    // keep only the levels TextureStreamer finds visible
+};
+
+struct TextureLoadStats {
+    unsigned int baked = 0;         // loaded from a ".gtex" container
+    unsigned int decoded = 0;       // decoded from the source image
+    size_t bakedBytes = 0;
+    size_t decodedBytes = 0;
+    double bakedMilliseconds = 0.0;     // map + upload
+    double decodedMilliseconds = 0.0;   // decode (worker time) + upload
+};
+
+// Decodes images and builds their mip chains on the shared ThreadPool, then
+// uploads them on the GL thread through pixel buffer objects into immutable
+// storage where available. The returned texture name is usable at once: it
+// holds a 1x1 placeholder until pump() replaces its contents. Images with an
+// up-to-date baked container skip decoding and upload compressed levels.
+// Streamed textures get only their small tail levels and are handed to
+// TextureStreamer. Cubemaps are mip-mapped and cached as one container
+// after the first decode, so warm starts skip decoding entirely.
+class TextureLoader {
+public:
+    struct Handle {
+        unsigned int id = 0;
+        std::shared_future<unsigned int> ready;   // resolves on the GL thread after upload
+    };
+
+    static Handle load2D(const std::string& path, const TextureOptions& options = TextureOptions(),
+                         std::function<void(unsigned int, size_t)> onReady = nullptr);
+
+    // Faces in GL order: +X, -X, +Y, -Y, +Z, -Z; decoded in parallel, or
+    // read from the cubemap cache when it is newer than every face
+    static Handle loadCube(const std::vector<std::string>& faces,
+                           std::function<void(unsigned int, size_t)> onReady = nullptr);
+
+    // GL thread, once per frame: uploads finished decodes, at most maxUploads of them
+    static void pump(unsigned int maxUploads = 4);
+
+    // Blocks until every queued texture is decoded and uploaded
+    static void finishAll();
+    // Blocks until one texture is decoded and uploaded
+    static void finish(unsigned int texture);
+    // Drops a pending load, e.g. when the texture is deleted first
+    static void cancel(unsigned int texture);
+
+    static size_t pending() { return requests.size(); }
+    static void cleanup();
+
+    // Synchronous load into the bound GL_TEXTURE_2D, baked container first.
+    // Returns false, leaving the texture untouched, when nothing could be loaded.
+    static bool loadNow(const std::string& path, const TextureOptions& options);
+
+    static TextureLoadStats GetStats();
+
+    // Level 0 first; RGB sources are widened to RGBA for alignment and SIMD
+    struct PreparedImage {
+        std::vector<DecodedImage> levels;
+        int sourceChannels = 0;
+
+        bool valid() const { return !levels.empty(); }
+    };
+
+    // Decode + mip chain, no GL; safe on worker threads
+    static PreparedImage prepare(const std::string& path, const TextureOptions& options);
+
+    // Sized format glTexStorage/glTexImage should allocate for an image
+    static GLenum internalFormat(int sourceChannels, bool srgb);
+    // Compressed format for a baked container; 0 when the driver cannot sample it
+    static GLenum compressedFormat(BlockFormat format, bool srgb);
+
+private:
+    friend class TextureStreamer;
+
+    struct Request {
+        unsigned int texture = 0;
+        GLenum target = GL_TEXTURE_2D;
+        TextureOptions options;
+        std::vector<std::string> paths;
+        std::vector<std::future<PreparedImage>> decodes;
+        std::shared_ptr<TextureContainer> baked;
+        std::promise<unsigned int> promise;
+        std::function<void(unsigned int, size_t)> onReady;
+    };
+
+    inline static std::vector<std::unique_ptr<Request>> requests;
+    inline static std::vector<GLuint> pbos;
+    inline static size_t nextPbo = 0;
+    inline static TextureLoadStats stats;
+    inline static std::atomic<long long> decodeMicroseconds{0};
+
+    static Handle enqueue(std::unique_ptr<Request> request);
+    static bool decoded(const Request& request);
+    static void upload(Request& request);
+    static size_t uploadFaces(GLenum target, const std::vector<PreparedImage>& faces, const TextureOptions& options,
+                              GLint baseLevel = 0);
+    static size_t uploadImage(GLenum faceTarget, GLint level, const DecodedImage& image,
+                              GLenum internalFormat, bool immutable);
+    static bool loadBaked(const std::string& path, const TextureOptions& options);
+    static std::shared_ptr<TextureContainer> openBaked(const std::string& path, const TextureOptions& options);
+    static std::shared_ptr<TextureContainer> openBakedCube(const std::vector<std::string>& faces, const TextureOptions& options);
+    // Writes the decoded faces and their mips to disk on a worker for the next start
+    static void cacheCubemap(const std::vector<std::string>& paths, const std::vector<PreparedImage>& faces);
+    static size_t uploadBaked(const TextureContainer& container, const TextureOptions& options, GLint baseLevel = 0);
+};
@@ -0,0 +1,334 @@
+#include "textureStreamer.hpp"
+#include "threadPool.hpp"
+#include "glState.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+    const int MAX_SLOTS = 0xFFFF;   // slot ids are packed into two 8-bit channels
+
+    int levelSize(int size, GLint level) {
+        int s = size >> level;
+        return s > 0 ? s : 1;
+    }
+
+    // Feedback blue channel: UV-space LOD in 1/8 steps, offset by 16
+    float decodeLod(unsigned char code) {
+        return code / 8.0f - 16.0f;
+    }
+}
+
+size_t TextureStreamer::Streamed::levelBytes(GLint level) const {
+    if (baked) return baked->levels()[level].size;
+    int bytesPerPixel = sourceChannels == 1 ? 1 : sourceChannels == 2 ? 2 : 4;
+    return (size_t)levelSize(width, level) * levelSize(height, level) * bytesPerPixel;
+}
+
+size_t TextureStreamer::Streamed::bytesFrom(GLint level) const {
+    size_t bytes = 0;
+    for (GLint l = level; l < levels; l++) bytes += levelBytes(l);
+    return bytes;
+}
+
+GLint TextureStreamer::tailLevel(int width, int height, int levels) {
+    GLint level = 0;
+    while (level < levels - 1 && std::max(levelSize(width, level), levelSize(height, level)) > TEXTURE_STREAM_TAIL_SIZE) {
+        level++;
+    }
+    return level;
+}
+
+void TextureStreamer::track(GLuint texture, const std::string& path, const TextureOptions& options,
+                            std::shared_ptr<TextureContainer> baked, TextureLoader::PreparedImage prepared,
+                            GLint residentBase) {
+    auto s = std::make_unique<Streamed>();
+    s->texture = texture;
+    s->path = path;
+    s->options = options;
+    if (baked) {
+        s->width = (int)baked->width();
+        s->height = (int)baked->height();
+        s->levels = (int)baked->mipCount();
+        s->baked = std::move(baked);
+    } else {
+        if (!prepared.valid()) return;
+        s->width = prepared.levels[0].width;
+        s->height = prepared.levels[0].height;
+        s->levels = (int)prepared.levels.size();
+        s->sourceChannels = prepared.sourceChannels;
+        s->prepared = std::move(prepared);
+    }
+    s->tail = s->resident = s->requested = s->wanted = residentBase;
+    textures[texture] = std::move(s);
+}
+
+void TextureStreamer::forget(GLuint texture) {
+    textures.erase(texture);
+}
+
+int TextureStreamer::slotFor(const std::vector<GLuint>& ids) {
+    std::vector<GLuint> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    if (sorted.empty()) return 0;
+
+    for (size_t i = 1; i < slots.size(); i++) {
+        if (slots[i] == sorted) return (int)i;
+    }
+    if ((int)slots.size() > MAX_SLOTS) return 0;
+    slots.push_back(std::move(sorted));
+    return (int)slots.size() - 1;
+}
+
+float TextureStreamer::feedbackBias() {
+    return std::log2((float)TEXTURE_FEEDBACK_DIVISOR);
+}
+
+void TextureStreamer::resizeFeedback(int width, int height) {
+    feedbackWidth = width;
+    feedbackHeight = height;
+    if (!feedbackFbo) {
+        glGenFramebuffers(1, &feedbackFbo);
+        glGenTextures(1, &feedbackColor);
+        glGenRenderbuffers(1, &feedbackDepth);
+        glGenBuffers(1, &readbackPbo);
+    }
+
+    GLState::bindFramebuffer(feedbackFbo);
+    GLState::bindTexture(GL_TEXTURE_2D, feedbackColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER:: Texture feedback framebuffer is not complete!\n";
+
+    // A readback of the old size is no longer meaningful
+    readbackPending = false;
+}
+
+bool TextureStreamer::beginFeedback(int screenWidth, int screenHeight) {
+    if (textures.empty() || frame % TEXTURE_FEEDBACK_INTERVAL != 0) return false;
+
+    // The previous pass had several frames to land in the PBO, so this does not stall
+    if (readbackPending) readFeedback();
+
+    int width = std::max(1, screenWidth / TEXTURE_FEEDBACK_DIVISOR);
+    int height = std::max(1, screenHeight / TEXTURE_FEEDBACK_DIVISOR);
+    if (width != feedbackWidth || height != feedbackHeight) resizeFeedback(width, height);
+
+    GLState::bindFramebuffer(feedbackFbo);
+    glViewport(0, 0, feedbackWidth, feedbackHeight);
+    GLState::enable(GL_DEPTH_TEST);
+    const GLfloat nothing[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, nothing);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    return true;
+}
+
+void TextureStreamer::endFeedback() {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackPbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)feedbackWidth * feedbackHeight * 4, nullptr, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackWidth = feedbackWidth;
+    readbackHeight = feedbackHeight;
+    readbackPending = true;
+
+    GLState::bindFramebuffer(0);
+}
+
+void TextureStreamer::readFeedback() {
+    readbackPending = false;
+    size_t size = (size_t)readbackWidth * readbackHeight * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackPbo);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (!pixels) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return;
+    }
+
+    // Finest UV-space LOD and coverage per slot
+    std::vector<float> slotLod(slots.size(), std::numeric_limits<float>::max());
+    std::vector<unsigned int> slotPixels(slots.size(), 0);
+    for (size_t i = 0; i < size; i += 4) {
+        size_t slot = pixels[i] | (pixels[i + 1] << 8);
+        if (slot == 0 || slot >= slots.size()) continue;
+        slotLod[slot] = std::min(slotLod[slot], decodeLod(pixels[i + 2]));
+        slotPixels[slot]++;
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    for (auto& [id, s] : textures) s->pixels = 0;
+
+    for (size_t slot = 1; slot < slots.size(); slot++) {
+        if (slotPixels[slot] == 0) continue;
+        for (GLuint id : slots[slot]) {
+            auto it = textures.find(id);
+            if (it == textures.end()) continue;
+            Streamed& s = *it->second;
+
+            // The same UV footprint needs a finer level on a larger texture
+            float lod = slotLod[slot] + std::log2((float)std::max(s.width, s.height));
+            GLint level = (GLint)std::clamp(std::floor(lod), 0.0f, (float)s.tail);
+            if (s.pixels == 0 || level < s.requested) s.requested = level;
+            s.pixels += slotPixels[slot];
+        }
+    }
+
+    for (auto& [id, s] : textures) {
+        if (s->pixels > 0) {
+            s->idleFrames = 0;
+            continue;
+        }
+        // Out of view for a while: let it fall back to the tail
+        s->idleFrames += TEXTURE_FEEDBACK_INTERVAL;
+        if (s->idleFrames >= TEXTURE_STREAM_IDLE_FRAMES) s->requested = s->tail;
+    }
+    fitBudget();
+}
+
+void TextureStreamer::fitBudget() {
+    std::vector<Streamed*> order;
+    size_t total = 0;
+    for (auto& [id, s] : textures) {
+        s->wanted = s->requested;
+        total += s->bytesFrom(s->wanted);
+        order.push_back(s.get());
+    }
+    wantedBytes = total;
+
+    // Least visible textures give up a level first, one level per round
+    std::sort(order.begin(), order.end(), [](const Streamed* a, const Streamed* b) { return a->pixels < b->pixels; });
+    bool trimmed = true;
+    while (total > budget && trimmed) {
+        trimmed = false;
+        for (Streamed* s : order) {
+            if (s->wanted >= s->tail) continue;
+            total -= s->levelBytes(s->wanted);
+            s->wanted++;
+            trimmed = true;
+            if (total <= budget) break;
+        }
+    }
+}
+
+void TextureStreamer::evict(Streamed& s, GLint level) {
+    GLState::bindTexture(GL_TEXTURE_2D, s.texture);
+    // Raise the base first so the sampler never sees a freed level
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    for (GLint l = s.resident; l < level; l++) {
+        // A 0x0 image releases the level's memory
+        glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        evictions++;
+    }
+    s.resident = level;
+    s.minLod = 0.0f;
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, 0.0f);
+}
+
+bool TextureStreamer::load(Streamed& s, GLint level) {
+    if (!s.baked && !s.prepared.valid()) {
+        // Levels of decoded textures come from a fresh decode on the pool
+        if (!s.decode.valid()) {
+            std::string path = s.path;
+            TextureOptions options = s.options;
+            s.decode = ThreadPool::shared().submit([path, options] { return TextureLoader::prepare(path, options); });
+            return false;
+        }
+        if (s.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+        s.prepared = s.decode.get();
+        if (!s.prepared.valid() || (int)s.prepared.levels.size() != s.levels) {
+            std::cout << "Texture changed on disk while streaming: " << s.path << std::endl;
+            s.prepared = TextureLoader::PreparedImage();
+            s.requested = s.wanted = s.tail;
+            return false;
+        }
+    }
+
+    GLState::bindTexture(GL_TEXTURE_2D, s.texture);
+    if (s.baked) {
+        const TextureLevel& data = s.baked->levels()[level];
+        GLenum format = TextureLoader::compressedFormat(s.baked->format(), s.options.srgb);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, data.width, data.height, 0, (GLsizei)data.size, data.data);
+    } else {
+        GLenum internalFormat = TextureLoader::internalFormat(s.sourceChannels, s.options.srgb);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        TextureLoader::uploadImage(GL_TEXTURE_2D, level, s.prepared.levels[level], internalFormat, false);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        s.preparedIdle = 0;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+    // MIN_LOD is relative to the base: keep sampling the old level, then fade
+    s.minLod += (float)(s.resident - level);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, s.minLod);
+    s.resident = level;
+    loads++;
+    return true;
+}
+
+void TextureStreamer::update(float deltaTime, unsigned int maxUploads) {
+    frame++;
+
+    std::vector<Streamed*> loading;
+    for (auto& [id, s] : textures) {
+        if (s->resident < s->wanted) evict(*s, s->wanted);
+        else if (s->resident > s->wanted) loading.push_back(s.get());
+    }
+
+    // Most visible first, one level per upload
+    std::sort(loading.begin(), loading.end(), [](const Streamed* a, const Streamed* b) { return a->pixels > b->pixels; });
+    unsigned int uploads = 0;
+    for (Streamed* s : loading) {
+        if (uploads >= maxUploads) break;
+        if (load(*s, s->resident - 1)) uploads++;
+    }
+
+    for (auto& [id, s] : textures) {
+        if (s->minLod > 0.0f) {
+            s->minLod = std::max(0.0f, s->minLod - deltaTime * 4.0f);
+            GLState::bindTexture(GL_TEXTURE_2D, s->texture);
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, s->minLod);
+        }
+        // Decoded chains are only worth keeping while levels are still going up
+        if (s->prepared.valid() && s->resident <= s->wanted && ++s->preparedIdle > TEXTURE_STREAM_IDLE_FRAMES) {
+            s->prepared = TextureLoader::PreparedImage();
+        }
+    }
+}
+
+TextureStreamStats TextureStreamer::stats() {
+    TextureStreamStats s;
+    s.textures = textures.size();
+    for (auto& [id, t] : textures) s.residentBytes += t->bytesFrom(t->resident);
+    s.wantedBytes = wantedBytes;
+    s.budget = budget;
+    s.loads = loads;
+    s.evictions = evictions;
+    return s;
+}
+
+void TextureStreamer::cleanup() {
+    textures.clear();
+    if (feedbackFbo) {
+        glDeleteFramebuffers(1, &feedbackFbo);
+        GLState::forgetFramebuffer(feedbackFbo);
+        glDeleteTextures(1, &feedbackColor);
+        GLState::forgetTexture(feedbackColor);
+        glDeleteRenderbuffers(1, &feedbackDepth);
+        glDeleteBuffers(1, &readbackPbo);
+        feedbackFbo = feedbackColor = feedbackDepth = readbackPbo = 0;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "textureLoader.hpp"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TEXTURE_STREAM_BUDGET (256u << 20)   // default VRAM budget for streamed textures
+#define TEXTURE_STREAM_TAIL_SIZE 128         // levels this size and smaller are always resident
+#define TEXTURE_FEEDBACK_DIVISOR 8           // feedback target is 1/8 of the screen per axis
+#define TEXTURE_FEEDBACK_INTERVAL 4          // frames between feedback passes
+#define TEXTURE_STREAM_IDLE_FRAMES 240       // unrequested textures drop back to their tail after this
+
+struct TextureStreamStats {
+    size_t textures = 0;
+    size_t residentBytes = 0;
+    size_t wantedBytes = 0;     // what feedback asked for before the budget was applied
+    size_t budget = 0;
+    unsigned int loads = 0;     // levels uploaded
+    unsigned int evictions = 0; // levels freed
+};
+
+// Keeps only the mip levels the camera needs of streamed textures. A low
+// resolution feedback pass writes, per pixel, a material slot and the mip
+// level its UVs need; the CPU reads it back a few frames later, picks a
+// base level per texture, trims the picks to the budget and then loads or
+// frees levels. GL_TEXTURE_BASE_LEVEL hides levels that are not resident and
+// GL_TEXTURE_MIN_LOD fades new levels in instead of popping them.
+//
+// Streamed textures use mutable storage so levels can be freed one at a time.
+class TextureStreamer {
+public:
+    // Called by TextureLoader once a streamed texture's tail is resident.
+    // `baked` (when set) serves levels from its mapping, otherwise they are
+    // decoded again from `path`; `prepared` is kept briefly to avoid that.
+    static void track(GLuint texture, const std::string& path, const TextureOptions& options,
+                      std::shared_ptr<TextureContainer> baked, TextureLoader::PreparedImage prepared,
+                      GLint residentBase);
+    static void forget(GLuint texture);
+
+    // First level TextureLoader should upload for a streamed texture
+    static GLint tailLevel(int width, int height, int levels);
+
+    // Feedback slot for a set of textures sampled with the same UVs, e.g. one
+    // mesh's material. Slot 0 is "nothing requested".
+    static int slotFor(const std::vector<GLuint>& textures);
+
+    // Binds the feedback target when a pass is due this frame; draw the
+    // streamed objects with the feedback shader, then call endFeedback().
+    // Leaves the default framebuffer bound and the viewport at feedback size.
+    static bool beginFeedback(int screenWidth, int screenHeight);
+    static void endFeedback();
+    static float feedbackBias();   // log2 of the divisor, for the feedback shader
+
+    // GL thread, once per frame: applies feedback, evicts and loads levels
+    static void update(float deltaTime, unsigned int maxUploads = 2);
+
+    static void setBudget(size_t bytes) { budget = bytes; }
+    static size_t getBudget() { return budget; }
+    static TextureStreamStats stats();
+    static void cleanup();
+
+private:
+    struct Streamed {
+        GLuint texture = 0;
+        std::string path;
+        TextureOptions options;
+        std::shared_ptr<TextureContainer> baked;
+        TextureLoader::PreparedImage prepared;     // decoded chain, dropped when idle
+        std::future<TextureLoader::PreparedImage> decode;
+        unsigned int preparedIdle = 0;
+
+        int width = 0;
+        int height = 0;
+        int levels = 0;
+        int sourceChannels = 4;
+        GLint tail = 0;         // coarsest level we keep for good
+        GLint resident = 0;     // finest level in memory
+        GLint requested = 0;    // finest level the feedback asked for
+        GLint wanted = 0;       // `requested` after the budget
+        float minLod = 0.0f;    // relative to the base level; fades to 0 after a load
+        unsigned int pixels = 0;        // feedback coverage, used as priority
+        unsigned int idleFrames = 0;
+
+        size_t levelBytes(GLint level) const;
+        size_t bytesFrom(GLint level) const;
+    };
+
+    inline static std::unordered_map<GLuint, std::unique_ptr<Streamed>> textures;
+    inline static std::vector<std::vector<GLuint>> slots = {{}};
+    inline static size_t budget = TEXTURE_STREAM_BUDGET;
+    inline static unsigned int loads = 0;
+    inline static unsigned int evictions = 0;
+    inline static size_t wantedBytes = 0;
+
+    inline static GLuint feedbackFbo = 0, feedbackColor = 0, feedbackDepth = 0;
+    inline static GLuint readbackPbo = 0;
+    inline static int feedbackWidth = 0, feedbackHeight = 0;
+    inline static int readbackWidth = 0, readbackHeight = 0;
+    inline static bool readbackPending = false;
+    inline static unsigned int frame = 0;
+
+    static void resizeFeedback(int width, int height);
+    static void readFeedback();
+    static void fitBudget();
+    static void evict(Streamed& s, GLint level);
+    static bool load(Streamed& s, GLint level);
+};
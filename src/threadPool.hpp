@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for CPU-only work (file reads, decoding,
+// mesh processing). Jobs must never touch GL; hand results back to the
+// GL thread instead.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threads = defaultThreadCount()) {
+        for (unsigned int i = 0; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    auto submit(F&& job) -> std::future<std::invoke_result_t<F>> {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push([task] { (*task)(); });
+        }
+        wake.notify_one();
+        return future;
+    }
+
+    // Runs body(i) for i in [0, count) across the pool and waits for all of them.
+    // The calling thread takes indices too, so it never waits behind other work
+    // queued ahead of the helpers (texture decodes, cache writes): helpers that
+    // start late find nothing left and return. Safe to call from a pool job.
+    template<typename F>
+    void parallelFor(size_t count, F&& body) {
+        if (count == 0) return;
+        struct Shared {
+            std::atomic<size_t> next{0};
+            size_t done = 0;
+            size_t count = 0;
+            std::function<void(size_t)> body;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            // Claims indices until none are left; `body` is only touched while one is held
+            void run() {
+                for (size_t i; (i = next.fetch_add(1)) < count;) {
+                    std::exception_ptr failed;
+                    try {
+                        body(i);
+                    } catch (...) {
+                        failed = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failed && !error) error = failed;
+                    if (++done == count) finished.notify_all();
+                }
+            }
+        };
+        auto shared = std::make_shared<Shared>();
+        shared->count = count;
+        shared->body = [&body](size_t i) { body(i); };
+
+        size_t helpers = std::min(count - 1, workers.size());
+        if (helpers) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (size_t i = 0; i < helpers; i++) jobs.push([shared] { shared->run(); });
+            }
+            wake.notify_all();
+        }
+        shared->run();
+
+        // Only indices already running on workers are left to wait for
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->finished.wait(lock, [&] { return shared->done == count; });
+        if (shared->error) std::rethrow_exception(shared->error);
+    }
+
+    unsigned int size() const { return (unsigned int)workers.size(); }
+
+    // Process-wide pool shared by loaders
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    static unsigned int defaultThreadCount() {
+        unsigned int cores = std::thread::hardware_concurrency();
+        // Leave one core for the GL thread
+        return std::max(1u, cores > 1 ? cores - 1 : 1u);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop();
+            }
+            job();
+        }
+    }
+};
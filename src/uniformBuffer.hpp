@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <utility>
+
+// Fixed binding points shared by every program. GLSL 330 has no
+// layout(binding = N) for blocks, so Shader binds these by name after linking.
+enum UniformBlockBinding : GLuint {
+    FRAME_DATA_BINDING = 0,
+    LIGHT_DATA_BINDING = 1,
+    BONE_PALETTE_BINDING = 2,   // ranged per draw, see AnimationSystem::bind
+};
+
+inline const std::pair<const char*, GLuint> uniformBlockBindings[] = {
+    {"FrameData", FRAME_DATA_BINDING},
+    {"LightData", LIGHT_DATA_BINDING},
+    {"BonePalette", BONE_PALETTE_BINDING},
+};
+
+// std140 mirror of the FrameData block in assets/shaders/frame_data.glsl
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPos;   // xyz = world position
+    glm::vec4 time;        // x = seconds since start, y = delta time
+};
+static_assert(sizeof(FrameData) == 224, "FrameData must match the std140 layout");
+
+class UniformBuffer {
+public:
+    UniformBuffer(GLuint binding, size_t size) : binding(binding), size(size) {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    template<typename T>
+    void update(const T& data) {
+        static_assert(sizeof(T) > 0, "empty uniform block");
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T) < size ? sizeof(T) : size, &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void cleanup() {
+        glDeleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+
+    GLuint Binding() const { return binding; }
+
+private:
+    GLuint ubo = 0;
+    GLuint binding;
+    size_t size;
+};
@@ -0,0 +1,142 @@
+#include "vertexAnimation.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // The blend shader.vs does with SKINNED: weighted palette matrices, the
+    // normal through their upper 3x3
+    void skinVertex(const Vertex& v, const JointMatrix* palette, size_t bones, glm::vec3& position, glm::vec3& normal) {
+        position = v.Position;
+        normal = v.Normal;
+        float skin[16] = {};
+        float total = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            float weight = v.m_Weights[i];
+            if (weight <= 0.0f || v.m_BoneIDs[i] < 0 || (size_t)v.m_BoneIDs[i] >= bones) continue;
+            const float* m = palette[v.m_BoneIDs[i]].m;
+            for (int k = 0; k < 16; k++) skin[k] += m[k] * weight;
+            total += weight;
+        }
+        if (total <= 0.0f) return;
+
+        // column-major: element (row r, column c) is skin[c * 4 + r]
+        const glm::vec3& p = v.Position;
+        const glm::vec3& n = v.Normal;
+        for (int r = 0; r < 3; r++) {
+            position[r] = skin[r] * p.x + skin[4 + r] * p.y + skin[8 + r] * p.z + skin[12 + r];
+            normal[r] = skin[r] * n.x + skin[4 + r] * n.y + skin[8 + r] * n.z;
+        }
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : v.Normal;
+    }
+
+    uint16_t toUnorm16(float unit) {
+        return (uint16_t)std::lround(std::min(std::max(unit, 0.0f), 1.0f) * 65535.0f);
+    }
+
+    int8_t toSnorm8(float value) {
+        return (int8_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 127.0f);
+    }
+}
+
+VertexAnimationBake bakeVertexAnimation(const Skeleton& skeleton,
+                                        const std::vector<std::shared_ptr<const CompressedClip>>& clips,
+                                        const std::vector<Vertex>& vertices, uint32_t maxWidth, uint32_t maxHeight) {
+    VertexAnimationBake bake;
+    if (vertices.empty() || clips.empty() || maxWidth == 0) return bake;
+
+    // Rows split evenly rather than filling all but the last, so less of each frame is padding
+    uint32_t count = (uint32_t)vertices.size();
+    bake.vertexCount = count;
+    bake.rowsPerFrame = (count + maxWidth - 1) / maxWidth;
+    bake.width = (count + bake.rowsPerFrame - 1) / bake.rowsPerFrame;
+
+    uint32_t maxFrames = maxHeight / bake.rowsPerFrame;
+    for (auto& clip : clips) {
+        if (bake.clips.size() == VAT_MAX_CLIPS || bake.frames == maxFrames) {
+            std::cout << "Vertex animation: clip '" << clip->name << "' and later ones not baked, "
+                      << (bake.clips.size() == VAT_MAX_CLIPS ? "clip table" : "texture height") << " full" << std::endl;
+            break;
+        }
+        uint32_t frames = std::max<uint32_t>(1, (uint32_t)std::lround(clip->duration * VAT_FRAMES_PER_SECOND));
+        VatClip vat;
+        vat.name = clip->name;
+        vat.firstFrame = bake.frames;
+        vat.frameCount = std::min(frames, maxFrames - bake.frames);
+        vat.framesPerSecond = clip->duration > 0.0f ? frames / clip->duration : 0.0f;
+        if (vat.frameCount < frames) {
+            std::cout << "Vertex animation: clip '" << clip->name << "' trimmed to " << vat.frameCount
+                      << " of " << frames << " frames, texture height full" << std::endl;
+        }
+        bake.frames += vat.frameCount;
+        bake.clips.push_back(vat);
+    }
+    if (bake.frames == 0) return bake;
+
+    // Palettes first, one clip per job so each cursor only moves forward
+    size_t bones = std::max<size_t>(skeleton.boneCount(), 1);
+    std::vector<JointMatrix> palettes((size_t)bake.frames * bones);
+    ThreadPool::shared().parallelFor(bake.clips.size(), [&](size_t c) {
+        const VatClip& vat = bake.clips[c];
+        ClipCursor cursor;
+        std::vector<JointPose> pose(skeleton.joints.size());
+        std::vector<JointMatrix> globals(pose.size());
+        std::vector<JointMatrix> palette(bones, identityMatrix());
+        for (uint32_t f = 0; f < vat.frameCount; f++) {
+            float time = vat.framesPerSecond > 0.0f ? f / vat.framesPerSecond : 0.0f;
+            sampleClip(skeleton, *clips[c], cursor, time, pose.data());
+            buildPalette(skeleton, pose.data(), globals.data(), palette.data());
+            std::copy(palette.begin(), palette.end(), palettes.begin() + (vat.firstFrame + f) * bones);
+        }
+    });
+
+    // Skinned twice, once for the bounds the positions are quantized to and
+    // once to write them, instead of keeping every frame as floats in between
+    std::vector<glm::vec3> frameMin(bake.frames, glm::vec3(0.0f)), frameMax(bake.frames, glm::vec3(0.0f));
+    ThreadPool::shared().parallelFor(bake.frames, [&](size_t f) {
+        const JointMatrix* palette = &palettes[f * bones];
+        glm::vec3 position, normal;
+        skinVertex(vertices[0], palette, bones, position, normal);
+        glm::vec3 low = position, high = position;
+        for (uint32_t v = 1; v < count; v++) {
+            skinVertex(vertices[v], palette, bones, position, normal);
+            low = glm::min(low, position);
+            high = glm::max(high, position);
+        }
+        frameMin[f] = low;
+        frameMax[f] = high;
+    });
+    bake.boundsMin = frameMin[0];
+    bake.boundsMax = frameMax[0];
+    for (uint32_t f = 1; f < bake.frames; f++) {
+        bake.boundsMin = glm::min(bake.boundsMin, frameMin[f]);
+        bake.boundsMax = glm::max(bake.boundsMax, frameMax[f]);
+    }
+
+    // Rows are `width` texels, so the texel of vertex v in frame f is simply
+    // f * rowsPerFrame * width + v; the tail of each frame's last row stays zero
+    size_t frameTexels = (size_t)bake.rowsPerFrame * bake.width;
+    bake.positions.assign(frameTexels * bake.frames * 4, 0);
+    bake.normals.assign(frameTexels * bake.frames * 4, 0);
+    glm::vec3 extent = bake.boundsMax - bake.boundsMin;
+    glm::vec3 scale(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                    extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+    ThreadPool::shared().parallelFor(bake.frames, [&](size_t f) {
+        const JointMatrix* palette = &palettes[f * bones];
+        uint16_t* positions = &bake.positions[f * frameTexels * 4];
+        int8_t* normals = &bake.normals[f * frameTexels * 4];
+        glm::vec3 position, normal;
+        for (uint32_t v = 0; v < count; v++) {
+            skinVertex(vertices[v], palette, bones, position, normal);
+            glm::vec3 unit = (position - bake.boundsMin) * scale;
+            for (int k = 0; k < 3; k++) {
+                positions[v * 4 + k] = toUnorm16(unit[k]);
+                normals[v * 4 + k] = toSnorm8(normal[k]);
+            }
+        }
+    });
+    return bake;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "animation.hpp"
+#include "vertexFormat.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define VAT_FRAMES_PER_SECOND 30.0f     // bake rate; the shader blends neighbouring frames
+#define VAT_MAX_CLIPS 16                // entries of the shader's clip table
+#define VAT_MAX_WIDTH 4096              // texels per row; larger meshes take several rows per frame
+
+// Frames [firstFrame, firstFrame + frameCount) of the bake. The rate is
+// stretched so frameCount frames span the clip exactly and the last frame
+// blends back into the first.
+struct VatClip {
+    std::string name;
+    uint32_t firstFrame = 0;
+    uint32_t frameCount = 0;
+    float framesPerSecond = 0.0f;
+};
+
+// Skinned positions and normals of every vertex, one block of rowsPerFrame
+// rows per frame: vertex v of frame f is texel (v % width, f * rowsPerFrame + v / width).
+// Positions are unorm16 fractions of [boundsMin, boundsMax], normals snorm8,
+// both RGBA with w unused so they upload as-is.
+struct VertexAnimationBake {
+    uint32_t width = 0;
+    uint32_t rowsPerFrame = 0;
+    uint32_t frames = 0;
+    uint32_t vertexCount = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    std::vector<uint16_t> positions;
+    std::vector<int8_t> normals;
+    std::vector<VatClip> clips;
+
+    uint32_t height() const { return frames * rowsPerFrame; }
+    size_t bytes() const { return positions.size() * sizeof(uint16_t) + normals.size() * sizeof(int8_t); }
+};
+
+// Plays every clip at VAT_FRAMES_PER_SECOND and skins `vertices` the way
+// shader.vs does with SKINNED; vertices without weights keep their bind
+// position. Clips past VAT_MAX_CLIPS or past `maxHeight` rows are dropped or
+// trimmed. Sampling and skinning run on the thread pool.
+VertexAnimationBake bakeVertexAnimation(const Skeleton& skeleton,
+                                        const std::vector<std::shared_ptr<const CompressedClip>>& clips,
+                                        const std::vector<Vertex>& vertices, uint32_t maxWidth, uint32_t maxHeight);
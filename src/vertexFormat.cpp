@@ -0,0 +1,197 @@
+#include "vertexFormat.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+    bool isSkinned(const Vertex& v) {
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            if (v.m_Weights[i] > 0.0f) return true;
+        }
+        return false;
+    }
+
+    PackedVertex packBase(const Vertex& v) {
+        PackedVertex p;
+        p.Position = v.Position;
+        p.Normal = packSnorm1010102(v.Normal, 0.0f);
+        p.TexCoords[0] = packHalf(v.TexCoords.x);
+        p.TexCoords[1] = packHalf(v.TexCoords.y);
+        float handedness = glm::dot(glm::cross(v.Normal, v.Tangent), v.Bitangent) < 0.0f ? -1.0f : 1.0f;
+        p.Tangent = packSnorm1010102(v.Tangent, handedness);
+        return p;
+    }
+
+    // Rounds to unorm8 and gives the rounding remainder to the largest
+    // weight, so the quantized weights still sum to exactly one
+    void packWeights(const Vertex& v, uint8_t* out) {
+        float sum = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) sum += v.m_Weights[i] > 0.0f ? v.m_Weights[i] : 0.0f;
+
+        int total = 0;
+        int largest = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            float w = sum > 0.0f && v.m_Weights[i] > 0.0f ? v.m_Weights[i] / sum : 0.0f;
+            out[i] = (uint8_t)std::lround(w * 255.0f);
+            total += out[i];
+            if (out[i] > out[largest]) largest = i;
+        }
+        if (sum > 0.0f) out[largest] = (uint8_t)(out[largest] + 255 - total);
+    }
+}
+
+VertexFormat chooseVertexFormat(const std::vector<Vertex>& vertices) {
+    bool skinned = false;
+    for (auto& v : vertices) {
+        if (std::fabs(v.TexCoords.x) > PACKED_UV_RANGE || std::fabs(v.TexCoords.y) > PACKED_UV_RANGE) {
+            return VertexFormat::Full;
+        }
+        if (!isSkinned(v)) continue;
+        skinned = true;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+            if (v.m_Weights[i] > 0.0f && (v.m_BoneIDs[i] < 0 || v.m_BoneIDs[i] > 255)) return VertexFormat::Full;
+        }
+    }
+    return skinned ? VertexFormat::PackedSkinned : VertexFormat::Packed;
+}
+
+size_t vertexStride(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed: return sizeof(PackedVertex);
+        case VertexFormat::PackedSkinned: return sizeof(PackedSkinnedVertex);
+        default: return sizeof(Vertex);
+    }
+}
+
+std::vector<unsigned char> packVertices(const std::vector<Vertex>& vertices, VertexFormat format) {
+    std::vector<unsigned char> out(vertices.size() * vertexStride(format));
+    unsigned char* dst = out.data();
+
+    for (auto& v : vertices) {
+        if (format == VertexFormat::Packed) {
+            PackedVertex p = packBase(v);
+            std::memcpy(dst, &p, sizeof(p));
+        } else if (format == VertexFormat::PackedSkinned) {
+            PackedSkinnedVertex p;
+            p.Base = packBase(v);
+            packWeights(v, p.Weights);
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+                p.BoneIDs[i] = p.Weights[i] ? (uint8_t)v.m_BoneIDs[i] : 0;
+            }
+            std::memcpy(dst, &p, sizeof(p));
+        } else {
+            std::memcpy(dst, &v, sizeof(v));
+        }
+        dst += vertexStride(format);
+    }
+    return out;
+}
+
+std::vector<Vertex> unpackVertices(const unsigned char* stream, size_t count, VertexFormat format) {
+    std::vector<Vertex> out(count);
+    if (format == VertexFormat::Full) {
+        std::memcpy(out.data(), stream, count * sizeof(Vertex));
+        return out;
+    }
+
+    size_t stride = vertexStride(format);
+    for (size_t i = 0; i < count; i++) {
+        PackedSkinnedVertex p{};
+        std::memcpy(&p, stream + i * stride, stride);
+
+        Vertex& v = out[i];
+        v = Vertex{};
+        v.Position = p.Base.Position;
+        v.Normal = glm::vec3(unpackSnorm1010102(p.Base.Normal));
+        v.TexCoords = glm::vec2(unpackHalf(p.Base.TexCoords[0]), unpackHalf(p.Base.TexCoords[1]));
+        glm::vec4 tangent = unpackSnorm1010102(p.Base.Tangent);
+        v.Tangent = glm::vec3(tangent);
+        v.Bitangent = glm::cross(v.Normal, v.Tangent) * tangent.w;
+        if (format == VertexFormat::PackedSkinned) {
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++) {
+                v.m_BoneIDs[k] = p.BoneIDs[k];
+                v.m_Weights[k] = p.Weights[k] / 255.0f;
+            }
+        }
+    }
+    return out;
+}
+
+uint32_t packSnorm1010102(const glm::vec3& v, float w) {
+    auto component = [](float x, float scale, uint32_t mask) {
+        x = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+        if (x != x) x = 0.0f;
+        return (uint32_t)(int32_t)std::lround(x * scale) & mask;
+    };
+    return component(v.x, 511.0f, 0x3FF) |
+           component(v.y, 511.0f, 0x3FF) << 10 |
+           component(v.z, 511.0f, 0x3FF) << 20 |
+           component(w, 1.0f, 0x3) << 30;
+}
+
+glm::vec4 unpackSnorm1010102(uint32_t packed) {
+    // Sign-extend each field, then map to [-1, 1] the way GL does
+    auto component = [packed](int shift, int bits) {
+        int32_t value = (int32_t)(packed << (32 - shift - bits)) >> (32 - bits);
+        float scale = (float)((1 << (bits - 1)) - 1);
+        float x = value / scale;
+        return x < -1.0f ? -1.0f : x;
+    };
+    return glm::vec4(component(0, 10), component(10, 10), component(20, 10), component(30, 2));
+}
+
+uint16_t packHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {                    // inf / nan
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00);   // overflow -> inf
+    if (exponent <= 0) {                                    // subnormal or zero
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // Round to nearest even; a carry out of the mantissa bumps the exponent
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return (uint16_t)(sign | half);
+}
+
+float unpackHalf(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);            // inf / nan
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;                                            // zero
+    } else {
+        // Subnormal: shift up until the implicit bit appears
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#define MAX_BONE_INFLUENCE 4
+#define PACKED_UV_RANGE 4.0f    // half-float UVs keep ~1/512 precision up to here
+
+
+// Import-side vertex: full precision, what ModelLoader produces and works on
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+	//bone indexes which will influence this vertex
+	int m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone
+	float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// GPU layouts. The packed ones are decoded by vertex fetch: normal and
+// tangent are snorm 10:10:10:2, UVs half floats. The bitangent is not
+// stored; it is cross(normal, tangent.xyz) * tangent.w.
+enum class VertexFormat : uint32_t {
+    Full = 0,           // Vertex as is (88 bytes)
+    Packed = 1,         // PackedVertex (24 bytes), no bone stream
+    PackedSkinned = 2,  // PackedSkinnedVertex (32 bytes), up to 256 bones
+};
+
+struct PackedVertex {
+    glm::vec3 Position;
+    uint32_t Normal;
+    uint16_t TexCoords[2];
+    uint32_t Tangent;           // w = bitangent sign
+};
+
+struct PackedSkinnedVertex {
+    PackedVertex Base;
+    uint8_t BoneIDs[MAX_BONE_INFLUENCE];
+    uint8_t Weights[MAX_BONE_INFLUENCE];    // unorm, sum to 255
+};
+
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex must stay tightly packed");
+static_assert(sizeof(PackedSkinnedVertex) == 32, "PackedSkinnedVertex must stay tightly packed");
+
+// The smallest layout that represents `vertices` without visible loss
+VertexFormat chooseVertexFormat(const std::vector<Vertex>& vertices);
+
+size_t vertexStride(VertexFormat format);
+
+// The GPU stream for `format`, vertexStride(format) bytes per vertex
+std::vector<unsigned char> packVertices(const std::vector<Vertex>& vertices, VertexFormat format);
+
+// Inverse of packVertices, up to the packed precision
+std::vector<Vertex> unpackVertices(const unsigned char* stream, size_t count, VertexFormat format);
+
+uint32_t packSnorm1010102(const glm::vec3& v, float w);
+glm::vec4 unpackSnorm1010102(uint32_t packed);
+uint16_t packHalf(float value);
+float unpackHalf(uint16_t half);
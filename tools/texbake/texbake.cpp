@@ -0,0 +1,97 @@
+// Offline texture baker: converts source images into ".gtex" containers
+// (full mip chain, BC1/BC3/BC4/BC5) that the renderer maps and uploads
+// without decoding.
+//
+// usage: texbake [--no-flip] [--no-mips] [--linear] [--srgb] [--force] [file-or-directory...]
+// With no paths it bakes everything under assets/ except cubemap faces.
+// Color images get gamma-correct mips unless --linear is given or the file
+// name marks them as data (specular, normal, AO, ...); --srgb forces them,
+// as TextureOptions::srgb does at runtime.
+
+#include "textureBaker.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    bool isImage(const fs::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp";
+    }
+
+    void collect(const fs::path& root, std::vector<std::string>& out) {
+        std::error_code ec;
+        if (fs::is_regular_file(root, ec)) {
+            out.push_back(root.generic_string());
+            return;
+        }
+        for (auto it = fs::recursive_directory_iterator(root, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            // Cubemap faces load unflipped through their own path
+            if (it->is_directory() && it->path().filename() == "skybox") {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_regular_file() && isImage(it->path())) out.push_back(it->path().generic_string());
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    BakeOptions options;
+    bool force = false;
+    std::vector<std::string> roots;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--no-flip") == 0) options.flip = false;
+        else if (std::strcmp(argv[i], "--no-mips") == 0) options.mipmaps = false;
+        else if (std::strcmp(argv[i], "--linear") == 0) options.color = false;
+        else if (std::strcmp(argv[i], "--srgb") == 0) options.srgb = true;
+        else if (std::strcmp(argv[i], "--force") == 0) force = true;
+        else roots.push_back(argv[i]);
+    }
+    if (roots.empty()) roots.push_back("assets");
+
+    std::vector<std::string> sources;
+    for (auto& root : roots) collect(root, sources);
+    if (!force) {
+        sources.erase(std::remove_if(sources.begin(), sources.end(), bakedTextureCurrent), sources.end());
+    }
+    if (sources.empty()) {
+        std::printf("Nothing to bake\n");
+        return 0;
+    }
+
+    std::vector<BakeResult> results(sources.size());
+    ThreadPool pool;
+    pool.parallelFor(sources.size(), [&](size_t i) {
+        BakeOptions fileOptions = options;
+        fileOptions.color = options.color && !looksLikeDataTexture(sources[i]);
+        results[i] = bakeTexture(sources[i], bakedTexturePath(sources[i]), fileOptions);
+    });
+
+    size_t before = 0, after = 0;
+    int failed = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        const BakeResult& r = results[i];
+        if (!r.ok) {
+            std::printf("FAILED  %s\n", sources[i].c_str());
+            failed++;
+            continue;
+        }
+        std::printf("%-4s %5ux%-5u %2u mips %8.1f KB -> %8.1f KB %7.1f ms  %s\n",
+                    blockFormatName(r.format), r.width, r.height, r.levels,
+                    r.uncompressedBytes / 1024.0, r.bakedBytes / 1024.0, r.milliseconds, sources[i].c_str());
+        before += r.uncompressedBytes;
+        after += r.bakedBytes;
+    }
+    std::printf("Baked %zu textures: %.1f MB RGBA8 -> %.1f MB compressed\n",
+                sources.size() - failed, before / (1024.0 * 1024.0), after / (1024.0 * 1024.0));
+    return failed ? 1 : 0;
+}